@@ -0,0 +1,176 @@
+/***************************************************************************//**
+ * @file actuator.c
+ * @brief Hardware-timed presses of the io remote buttons
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "actuator.h"
+#include "actuator_config.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_timer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define BUTTON_COUNT 3
+
+// Timer ticks are HFPERCLK / 1024, some 37 kHz
+#define PRESCALE     timerPrescale1024
+#define PRESCALE_DIV 1024
+
+// Largest TOP value of a timer with a counter this many bits wide
+#define MAX_TICKS(width) ((width) == 32 ? 0xFFFFFFFFUL : 0xFFFFUL)
+
+#if (ACTUATOR_MY_WIDTH != 16 && ACTUATOR_MY_WIDTH != 32)     \
+  || (ACTUATOR_UP_WIDTH != 16 && ACTUATOR_UP_WIDTH != 32)    \
+  || (ACTUATOR_DOWN_WIDTH != 16 && ACTUATOR_DOWN_WIDTH != 32)
+#error "ACTUATOR_*_WIDTH must be 16 for a TIMER or 32 for a WTIMER"
+#endif
+
+typedef struct {
+  TIMER_TypeDef* timer;
+  CMU_Clock_TypeDef clock;
+  GPIO_Port_TypeDef port;
+  uint8_t pin;
+  uint8_t location;
+  uint32_t max_ticks;
+} button_output_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void init_output(const button_output_t* output);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// In ACTUATOR_* bit order
+static const button_output_t outputs[BUTTON_COUNT] = {
+  { ACTUATOR_MY_PERIPHERAL, ACTUATOR_MY_CLOCK, ACTUATOR_MY_PORT,
+    ACTUATOR_MY_PIN, ACTUATOR_MY_LOC, MAX_TICKS(ACTUATOR_MY_WIDTH) },
+  { ACTUATOR_UP_PERIPHERAL, ACTUATOR_UP_CLOCK, ACTUATOR_UP_PORT,
+    ACTUATOR_UP_PIN, ACTUATOR_UP_LOC, MAX_TICKS(ACTUATOR_UP_WIDTH) },
+  { ACTUATOR_DOWN_PERIPHERAL, ACTUATOR_DOWN_CLOCK, ACTUATOR_DOWN_PORT,
+    ACTUATOR_DOWN_PIN, ACTUATOR_DOWN_LOC, MAX_TICKS(ACTUATOR_DOWN_WIDTH) },
+};
+
+static uint32_t hold_time_ms;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Set up the button outputs
+ *****************************************************************************/
+void actuator_init(void)
+{
+  for(size_t i = 0; i < BUTTON_COUNT; i++) {
+    init_output(&outputs[i]);
+  }
+
+  actuator_set_hold_time(ACTUATOR_HOLD_TIME_MS);
+}
+
+/******************************************************************************
+ * Change the hold time
+ *****************************************************************************/
+void actuator_set_hold_time(uint32_t hold_ms)
+{
+  hold_time_ms = hold_ms;
+
+  for(size_t i = 0; i < BUTTON_COUNT; i++) {
+    const button_output_t* output = &outputs[i];
+    uint64_t ticks = (uint64_t)CMU_ClockFreqGet(output->clock)
+                     / PRESCALE_DIV * hold_ms / 1000;
+
+    // The button goes down on the first tick and up again on overflow
+    if(ticks < 2) {
+      ticks = 2;
+    } else if(ticks > output->max_ticks) {
+      ticks = output->max_ticks;
+    }
+    TIMER_TopSet(output->timer, (uint32_t)ticks);
+  }
+}
+
+/******************************************************************************
+ * Get the hold time
+ *****************************************************************************/
+uint32_t actuator_get_hold_time(void)
+{
+  return hold_time_ms;
+}
+
+/******************************************************************************
+ * Press io remote buttons
+ *****************************************************************************/
+void actuator_press(uint8_t buttons)
+{
+  for(size_t i = 0; i < BUTTON_COUNT; i++) {
+    if(buttons & (1U << i)) {
+      outputs[i].timer->CMD = TIMER_CMD_START;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void init_output(const button_output_t* output)
+{
+  CMU_ClockEnable(output->clock, true);
+
+  // A timer only takes a TOP value as wide as its counter, and none at all
+  // without its clock. Either way round, a config which does not match the
+  // timer would cut presses short.
+  TIMER_TopSet(output->timer, 0xFFFFFFFFUL);
+  EFM_ASSERT(TIMER_TopGet(output->timer) == output->max_ticks);
+
+  // Released until the timer takes over the pin
+  GPIO_PinModeSet(output->port,
+                  output->pin,
+                  gpioModePushPull,
+                  ACTUATOR_ACTIVE_LOW ? 1 : 0);
+
+  // One-shot: after a start the timer counts up to TOP once and stops at 0
+  TIMER_Init_TypeDef timer_init = TIMER_INIT_DEFAULT;
+  timer_init.enable = false;
+  timer_init.oneShot = true;
+  timer_init.prescale = PRESCALE;
+  TIMER_Init(output->timer, &timer_init);
+
+  // Assert on the first tick, release on overflow
+  TIMER_InitCC_TypeDef cc_init = TIMER_INITCC_DEFAULT;
+  cc_init.mode = timerCCModeCompare;
+  cc_init.cmoa = timerOutputActionSet;
+  cc_init.cofoa = timerOutputActionClear;
+  cc_init.outInvert = ACTUATOR_ACTIVE_LOW ? true : false;
+  TIMER_InitCC(output->timer, 0, &cc_init);
+  TIMER_CompareSet(output->timer, 0, 1);
+
+  output->timer->ROUTELOC0 = (uint32_t)output->location
+                             << _TIMER_ROUTELOC0_CC0LOC_SHIFT;
+  output->timer->ROUTEPEN = TIMER_ROUTEPEN_CC0PEN;
+}
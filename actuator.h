@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file actuator.h
+ * @brief Hardware-timed presses of the io remote buttons
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// io remote buttons. The values match the bits of the RTS button code, so
+/// an RTS button combination such as MY+UP presses both buttons.
+#define ACTUATOR_MY   0x01
+#define ACTUATOR_UP   0x02
+#define ACTUATOR_DOWN 0x04
+#define ACTUATOR_ALL  (ACTUATOR_MY | ACTUATOR_UP | ACTUATOR_DOWN)
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Set up the button outputs, all released. Call once at boot.
+ *
+ * Every button has a timer of its own running one-shot. Its CC0 output
+ * drives the button line: it is asserted one tick after the timer starts and
+ * released in hardware when the timer reaches the hold time and stops.
+ *****************************************************************************/
+void actuator_init(void);
+
+/**************************************************************************//**
+ * Change how long a press holds a button down.
+ *
+ * @param hold_ms Hold time in ms, clamped to what the timers can count
+ *
+ * Takes effect from the next press.
+ *****************************************************************************/
+void actuator_set_hold_time(uint32_t hold_ms);
+
+/**************************************************************************//**
+ * Get how long a press holds a button down.
+ *
+ * @returns Hold time in ms, as last set
+ *****************************************************************************/
+uint32_t actuator_get_hold_time(void);
+
+/**************************************************************************//**
+ * Press io remote buttons.
+ *
+ * @param buttons ACTUATOR_* bits of the buttons to press
+ *
+ * Starts the timer of each button, one register write per button, and
+ * returns straight away. Pressing a button which is still held does not
+ * extend the press.
+ *****************************************************************************/
+void actuator_press(uint8_t buttons);
+
+#endif  // ACTUATOR_H
@@ -0,0 +1,168 @@
+/***************************************************************************//**
+ * @file actuator_queue.c
+ * @brief Commands for the io remote, queued between frames and presses
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "actuator_queue.h"
+#include "actuator.h"
+#include "actuator_config.h"
+#include <stddef.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define US_PER_MS 1000UL
+
+// Commands which only move the blind, and so are undone by the next command
+#define MOVES (ACTUATOR_UP | ACTUATOR_DOWN)
+
+typedef struct {
+  uint8_t buttons;
+  uint32_t queued_at;
+} command_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool is_duplicate(uint8_t buttons, uint32_t now);
+static void cancel_moves(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// Waiting commands, oldest first. Short enough to shift on removal.
+static command_t commands[ACTUATOR_QUEUE_SIZE];
+static uint8_t depth;
+
+// Newest pressed command, for merging and for the gap between presses
+static command_t last_pressed;
+static bool pressed_any;
+
+static actuator_queue_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Queue a command
+ *****************************************************************************/
+bool actuator_queue_push(uint8_t buttons, uint32_t now)
+{
+  if(buttons == 0) {
+    return false;
+  }
+
+  if(is_duplicate(buttons, now)) {
+    stats.coalesced++;
+    return true;
+  }
+
+  cancel_moves();
+
+  if(depth == ACTUATOR_QUEUE_SIZE) {
+    stats.dropped++;
+    return false;
+  }
+
+  commands[depth].buttons = buttons;
+  commands[depth].queued_at = now;
+  depth++;
+
+  // Most of the time the io remote is idle, so press without waiting for
+  // the next pass of the main loop
+  actuator_queue_process(now);
+  return true;
+}
+
+/******************************************************************************
+ * Press the next command once the io remote is ready
+ *****************************************************************************/
+void actuator_queue_process(uint32_t now)
+{
+  if(depth == 0) {
+    return;
+  }
+
+  uint32_t busy_us = (actuator_get_hold_time() + ACTUATOR_MIN_GAP_MS)
+                     * US_PER_MS;
+  if(pressed_any && now - last_pressed.queued_at < busy_us) {
+    return;
+  }
+
+  actuator_press(commands[0].buttons);
+  stats.pressed++;
+
+  // Merging goes by when the command was pressed from here on
+  last_pressed.buttons = commands[0].buttons;
+  last_pressed.queued_at = now;
+  pressed_any = true;
+
+  depth--;
+  for(size_t i = 0; i < depth; i++) {
+    commands[i] = commands[i + 1];
+  }
+}
+
+/******************************************************************************
+ * Get the queue telemetry
+ *****************************************************************************/
+void actuator_queue_get_stats(actuator_queue_stats_t* out)
+{
+  *out = stats;
+  out->depth = depth;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+// Same buttons as the newest command, waiting or pressed, and close enough
+// to it to be the same press from another remote or a second tap
+static bool is_duplicate(uint8_t buttons, uint32_t now)
+{
+  const command_t* newest;
+
+  if(depth > 0) {
+    newest = &commands[depth - 1];
+  } else if(pressed_any) {
+    newest = &last_pressed;
+  } else {
+    return false;
+  }
+
+  return newest->buttons == buttons
+         && now - newest->queued_at < ACTUATOR_COALESCE_MS * US_PER_MS;
+}
+
+// Drop every UP or DOWN still waiting, a newer command supersedes it
+static void cancel_moves(void)
+{
+  size_t kept = 0;
+
+  for(size_t i = 0; i < depth; i++) {
+    if((commands[i].buttons & ~MOVES) == 0) {
+      stats.cancelled++;
+    } else {
+      commands[kept++] = commands[i];
+    }
+  }
+  depth = (uint8_t)kept;
+}
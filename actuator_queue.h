@@ -0,0 +1,76 @@
+/***************************************************************************//**
+ * @file actuator_queue.h
+ * @brief Commands for the io remote, queued between frames and presses
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef ACTUATOR_QUEUE_H
+#define ACTUATOR_QUEUE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of commands waiting to be pressed. Duplicates are merged and
+/// superseded moves cancelled, so only a burst of different commands from
+/// several remotes at once can fill it up.
+#define ACTUATOR_QUEUE_SIZE 4
+
+/// Queue telemetry
+typedef struct {
+  uint32_t pressed;               ///< Commands pressed on the io remote
+  uint32_t coalesced;             ///< Commands merged into the one before
+  uint32_t cancelled;             ///< UP/DOWN superseded before being pressed
+  uint32_t dropped;               ///< Commands dropped because queue was full
+  uint8_t depth;                  ///< Current number of waiting commands
+} actuator_queue_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Queue a command, and press it straight away if the io remote is ready.
+ * Main loop only.
+ *
+ * @param buttons ACTUATOR_* bits of the buttons to press
+ * @param now Current time in us, wrapping
+ * @returns true if the command was queued or merged, false if dropped
+ *
+ * A command for the same buttons as the newest command, queued or pressed,
+ * less than ACTUATOR_COALESCE_MS ago is merged into it. Any UP or DOWN still
+ * waiting is cancelled by a newer command, since the blind would only end up
+ * where the newer one takes it anyway.
+ *****************************************************************************/
+bool actuator_queue_push(uint8_t buttons, uint32_t now);
+
+/**************************************************************************//**
+ * Press the next command once the io remote has let go of the last press for
+ * ACTUATOR_MIN_GAP_MS. Call from the main loop.
+ *
+ * @param now Current time in us, wrapping
+ *****************************************************************************/
+void actuator_queue_process(uint32_t now);
+
+/**************************************************************************//**
+ * Get the queue telemetry.
+ *
+ * @param stats Receives the telemetry
+ *****************************************************************************/
+void actuator_queue_get_stats(actuator_queue_stats_t* stats);
+
+#endif  // ACTUATOR_QUEUE_H
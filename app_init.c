@@ -20,6 +20,10 @@
 // -----------------------------------------------------------------------------
 #include "sl_rail_util_init.h"
 #include "sl_board_control.h"
+#include "app_process.h"
+#include "log_ring.h"
+#include "remote_table.h"
+#include "actuator.h"
 
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
@@ -48,9 +52,21 @@ RAIL_Handle_t app_init(void)
   // Turn on vcom
   sl_board_enable_vcom();
 
+  // Log through a RAM buffer drained by LDMA, printf() must never block
+  log_ring_init();
+
   // Get RAIL handle, used later by the application
   RAIL_Handle_t rail_handle = sl_rail_util_get_handle(SL_RAIL_UTIL_HANDLE_INST0);
 
+  // Only frames from paired remotes are acted on
+  remote_table_init();
+
+  // io remote buttons, released until the first accepted press
+  actuator_init();
+
+  // Get told about every chunk of a capture as it comes in
+  RAIL_SetRxFifoThreshold(rail_handle, RX_STREAM_CHUNK_BYTES);
+
   // Receive-only for now
   RAIL_StartRx(rail_handle, 0, NULL);
 
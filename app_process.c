@@ -20,19 +20,63 @@
 // -----------------------------------------------------------------------------
 #include "rail.h"
 #include "sl_iostream.h"
+#include "em_core.h"
 #include <stdint.h>
 
+#include "rts_decoder.h"
+#include "rx_packet_queue.h"
+#include "app_process.h"
+#include "log_ring.h"
+#include "bridge_event.h"
+#include "remote_table.h"
+#include "actuator.h"
+#include "actuator_queue.h"
+#include "frame_cache.h"
+#include "frame_combiner.h"
+#include "sl_simple_button_instances.h"
+
 #include "nvm3_default.h"
 
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
 // -----------------------------------------------------------------------------
+// Button code of the PROG button, used to pair and unpair in learning mode
+#define BUTTON_PROG 8
+// Learning mode ends by itself after this long, in RAIL time (us)
+#define LEARNING_TIMEOUT_US 30000000UL
+// A capture which failed is decoded again with the learned timing of remotes
+// at least this far off the nominal rate (1/32 samples per HW sync pulse,
+// about 3%), and each timing at least this far off those already tried.
+// Closer than that, the result would be the same.
+#define TIMED_DECODE_MIN_OFFSET (RTS_HW_SYNC_NOMINAL / 32)
+// A failed capture is decoded again with the timing of at most this many
+// remotes, those closest to the timing measured on the capture first
+#define TIMED_DECODE_MAX_TRIES 2
+
+#if REMOTE_TABLE_CAPACITY > UINT8_MAX
+#error "The drops event reports the paired remotes in one byte"
+#endif
 
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
 // -----------------------------------------------------------------------------
-static bool decodePacket(size_t received_bytes);
-static void parsePacket(void);
+static void streamPacket(RAIL_Handle_t rail_handle);
+static void armStream(RAIL_Handle_t rail_handle, uint16_t leaving);
+static rts_decode_status_t decodePacket(const rx_packet_t* packet,
+                                        const rts_capture_t* capture);
+static bool decodeTimed(const rts_capture_t* capture, uint16_t measured);
+static const remote_t* nextTimed(uint16_t measured,
+                                 const uint16_t* tried,
+                                 size_t tries);
+static uint16_t timingOffset(uint16_t a, uint16_t b);
+static uint8_t eventFlags(const rx_packet_t* packet, const rts_frame_t* frame);
+static uint32_t frameAddress(const rts_frame_t* frame);
+static bool checkDecode(const rx_packet_t* packet,
+                        rts_decode_status_t status,
+                        const rts_frame_t* frame);
+static void parsePacket(const rx_packet_t* packet, const rts_frame_t* frame);
+static void updateLearning(void);
+static void reportDrops(void);
 
 // -----------------------------------------------------------------------------
 //                                Global Variables
@@ -41,9 +85,23 @@ static void parsePacket(void);
 // -----------------------------------------------------------------------------
 //                                Static Variables
 // -----------------------------------------------------------------------------
-static volatile int packet_received = 0;
-static uint8_t packet_buffer[86];
-static uint8_t decoded_buffer[7];
+// Both decoders stop early on repeats of a frame which was already handled
+static rts_decoder_t decoder = { .lookup = frame_cache_lookup };
+static uint32_t lost_packets = 0;
+static uint32_t reported_drops = 0;
+static uint32_t reported_lost = 0;
+static uint32_t reported_log_drops = 0;
+static uint32_t reported_actuator_drops = 0;
+static size_t reported_paired = 0;
+
+// Learning mode, BTN0 asks for it from the button ISR
+static volatile bool learning_requested = false;
+static bool learning = false;
+static RAIL_Time_t learning_start;
+
+// Decoder for the capture being received, only touched from the RAIL ISR
+static rts_decoder_t stream_decoder = { .lookup = frame_cache_lookup };
+static RAIL_RxPacketHandle_t stream_handle = RAIL_RX_PACKET_HANDLE_INVALID;
 
 // -----------------------------------------------------------------------------
 //                          Public Function Definitions
@@ -61,35 +119,75 @@ void app_process_action(RAIL_Handle_t rail_handle)
   // Do not call blocking functions from here!                             //
   ///////////////////////////////////////////////////////////////////////////
 
-  if(packet_received == 1) {
+  updateLearning();
+
+  rx_packet_t packet;
+  while(rx_packet_queue_pop(&packet)) {
+    if(packet.status == RTS_DECODE_OK) {
+      // Decoded by the ISR before the capture was even complete
+      parsePacket(&packet, &packet.frame);
+      continue;
+    }
+
     RAIL_RxPacketInfo_t packetinfo;
-    RAIL_RxPacketHandle_t handle = RAIL_GetRxPacketInfo(
-        rail_handle, RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE, &packetinfo);
-
-    // Reset the flag before emptying the packet queue to avoid dropping frames
-    packet_received = 0;
-
-    while(handle != RAIL_RX_PACKET_HANDLE_INVALID &&
-          handle != RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE) {
-      // Parse the packet content
-      if(packetinfo.packetBytes <= sizeof(packet_buffer)) {
-        RAIL_CopyRxPacket(packet_buffer, &packetinfo);
-        if(decodePacket(packetinfo.packetBytes)) {
-          parsePacket();
-        }
-      } else {
-        printf("OVF!\n");
-      }
+    RAIL_RxPacketHandle_t handle = RAIL_GetRxPacketInfo(rail_handle,
+                                                        packet.handle,
+                                                        &packetinfo);
 
-      // Release packet
-      RAIL_ReleaseRxPacket(rail_handle, handle);
+    if(handle == RAIL_RX_PACKET_HANDLE_INVALID) {
+      lost_packets++;
+      continue;
+    }
 
-      // Get the next packet handle
-      handle = RAIL_GetRxPacketInfo(rail_handle,
-                                    RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE,
-                                    &packetinfo);
+    // Decode straight out of the RX FIFO, the capture may wrap around its end
+    rts_capture_t capture = {
+      .first = packetinfo.firstPortionData,
+      .first_length = packetinfo.firstPortionBytes,
+      .last = packetinfo.lastPortionData,
+      .length = packetinfo.packetBytes,
+    };
+    rts_decode_status_t status = decodePacket(&packet, &capture);
+
+    // The frame lives in the decoder now, so give the FIFO space back to RAIL
+    // before doing anything slow with it
+    RAIL_ReleaseRxPacket(rail_handle, handle);
+    armStream(rail_handle, 0);
+
+    if(checkDecode(&packet, status, &decoder.frame)) {
+      parsePacket(&packet, &decoder.frame);
     }
   }
+
+  reportDrops();
+
+  // Report how long each press lasted, once its repeats have stopped
+  frame_cache_release_t release;
+  while(frame_cache_expire(RAIL_GetTime(), &release)) {
+    bridge_event_send_release(release.address,
+                              release.button,
+                              release.repeats,
+                              release.held_us);
+  }
+
+  // Press the next queued command once the io remote is ready for it
+  actuator_queue_process(RAIL_GetTime());
+
+  // Store accepted rolling codes once enough of them have piled up
+  remote_table_process(RAIL_GetTime());
+
+  // Keep the log draining in the background
+  log_ring_process();
+}
+
+/******************************************************************************
+ * Button callback, called from ISR context on a button press or release
+ *****************************************************************************/
+void sl_button_on_change(const sl_button_t* handle)
+{
+  if(handle == &sl_button_btn0
+     && sl_button_get_state(handle) == SL_SIMPLE_BUTTON_PRESSED) {
+    learning_requested = true;
+  }
 }
 
 /******************************************************************************
@@ -105,10 +203,58 @@ void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events)
   // This is called from ISR context.                                      //
   // Do not call blocking functions from here!                             //
   ///////////////////////////////////////////////////////////////////////////
+  if(events & RAIL_EVENT_RX_FIFO_ALMOST_FULL) {
+    streamPacket(rail_handle);
+  }
+
   if(events & RAIL_EVENT_RX_PACKET_RECEIVED) {
+      rx_packet_t packet = {
+        .timestamp = RAIL_GetTime(),
+        .events = events,
+        .rssi = RAIL_RSSI_INVALID_DBM,
+        .status = RTS_DECODE_BUSY,
+      };
+
+      // Nothing left to do if the frame was already handed over while it was
+      // streaming in. Without a hold, RAIL frees the packet after this event.
+      RAIL_RxPacketInfo_t packetinfo;
+      RAIL_RxPacketHandle_t handle = RAIL_GetRxPacketInfo(
+        rail_handle, RAIL_RX_PACKET_HANDLE_NEWEST, &packetinfo);
+      bool streamed = stream_handle != RAIL_RX_PACKET_HANDLE_INVALID
+                      && stream_handle == handle
+                      && stream_decoder.status == RTS_DECODE_OK;
+      stream_handle = RAIL_RX_PACKET_HANDLE_INVALID;
+      if(streamed) {
+        armStream(rail_handle, packetinfo.packetBytes);
+        return;
+      }
+
       // Place a hold on this packet. We'll retrieve it from the main loop.
-      RAIL_HoldRxPacket(rail_handle);
-      packet_received = 1;
+      packet.handle = RAIL_HoldRxPacket(rail_handle);
+
+      if(packet.handle != RAIL_RX_PACKET_HANDLE_INVALID) {
+        RAIL_RxPacketDetails_t details;
+        if(RAIL_GetRxPacketDetailsAlt(rail_handle, packet.handle, &details)
+           == RAIL_STATUS_NO_ERROR) {
+          packet.rssi = details.rssi;
+        }
+
+        if(!rx_packet_queue_push(&packet)) {
+          // No room in the queue, give the FIFO space back to RAIL
+          RAIL_ReleaseRxPacket(rail_handle, packet.handle);
+        }
+        armStream(rail_handle, 0);
+      } else {
+        armStream(rail_handle, handle != RAIL_RX_PACKET_HANDLE_INVALID
+                               ? packetinfo.packetBytes : 0);
+      }
+  } else if(events & (RAIL_EVENT_RX_PACKET_ABORTED
+                      | RAIL_EVENT_RX_FRAME_ERROR
+                      | RAIL_EVENT_RX_FIFO_OVERFLOW)) {
+    // The capture being streamed will never complete, and RAIL has already
+    // dropped what there was of it
+    stream_handle = RAIL_RX_PACKET_HANDLE_INVALID;
+    armStream(rail_handle, 0);
   }
 }
 
@@ -116,30 +262,82 @@ void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events)
 //                          Static Function Definitions
 // -----------------------------------------------------------------------------
 
-#define GET_BIT_AT(buf, pos) (((((buf)[(pos)/8] >> (7-((pos)%8))) & 1) == 1) ? 1 : 0)
-#define SET_BIT_AT(buf, pos) (buf)[(pos)/8] |= (1 << (7-(pos%8)))
-#define CLR_BIT_AT(buf, pos) (buf)[(pos)/8] &= ~(1 << (7-(pos%8)))
-
-static size_t bits_until_next_edge(uint8_t* buf, size_t start_pos)
+// Decode the part of the capture in progress which came in since the last
+// call, and hand the frame to the main loop as soon as it decodes. A capture
+// which fails is held instead, so the main loop can combine it with other
+// copies or retry it with learned timing once it is complete.
+static void streamPacket(RAIL_Handle_t rail_handle)
 {
-  unsigned int start_state = GET_BIT_AT(buf, start_pos);
-  size_t cursor = start_pos + 1;
-  while(GET_BIT_AT(buf, cursor) == start_state) {
-      cursor++;
+  RAIL_RxPacketInfo_t packetinfo;
+  RAIL_RxPacketHandle_t handle = RAIL_GetRxPacketInfo(
+    rail_handle, RAIL_RX_PACKET_HANDLE_NEWEST, &packetinfo);
+
+  if(handle != RAIL_RX_PACKET_HANDLE_INVALID) {
+    if(handle != stream_handle) {
+      rts_decoder_start(&stream_decoder);
+      stream_handle = handle;
+    }
+
+    if(stream_decoder.status == RTS_DECODE_BUSY) {
+      rts_capture_t capture = {
+        .first = packetinfo.firstPortionData,
+        .first_length = packetinfo.firstPortionBytes,
+        .last = packetinfo.lastPortionData,
+        .length = packetinfo.packetBytes,
+      };
+      rts_decode_status_t status = rts_decoder_feed(&stream_decoder, &capture);
+
+      if(status == RTS_DECODE_OK) {
+        // The packet details, RSSI included, only come once the packet is
+        // complete. The remote is still sending, so sample the RSSI now.
+        int16_t rssi = RAIL_GetRssi(rail_handle, false);
+        rx_packet_t packet = {
+          .handle = RAIL_RX_PACKET_HANDLE_INVALID,
+          .timestamp = RAIL_GetTime(),
+          .events = RAIL_EVENT_RX_FIFO_ALMOST_FULL,
+          .rssi = rssi == RAIL_RSSI_INVALID
+                  ? RAIL_RSSI_INVALID_DBM : (int8_t)(rssi / 4),
+          .status = status,
+          .frame = stream_decoder.frame,
+        };
+        if(!rx_packet_queue_try_push(&packet)) {
+          // Leave it to the main loop to decode the complete capture instead.
+          // Nothing is lost yet, so this is no drop.
+          stream_handle = RAIL_RX_PACKET_HANDLE_INVALID;
+        }
+      }
+    }
   }
 
-  return cursor - start_pos;
+  // The event only fires again once the FIFO fills up past a new threshold
+  armStream(rail_handle, 0);
+}
+
+// Get told once the next RX_STREAM_CHUNK_BYTES are in the RX FIFO. The
+// threshold is a fill level, so it has to follow the FIFO back down whenever
+// a packet leaves it, or no later capture would ever reach it. 'leaving' is
+// what RAIL is about to free on its own. Main loop and RAIL ISR.
+static void armStream(RAIL_Handle_t rail_handle, uint16_t leaving)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_ATOMIC();
+  uint16_t fill = RAIL_GetRxFifoBytesAvailable(rail_handle);
+  RAIL_SetRxFifoThreshold(rail_handle,
+                          (uint16_t)((fill > leaving ? fill - leaving : 0)
+                                     + RX_STREAM_CHUNK_BYTES));
+  CORE_EXIT_ATOMIC();
 }
 
-static bool decodePacket(size_t received_bytes)
+static rts_decode_status_t decodePacket(const rx_packet_t* packet,
+                                        const rts_capture_t* capture)
 {
   /*
   // Debug: print raw received bits
   printf("Packet received: b'[");
-  for(size_t i = 0; i < received_bytes; i++) {
+  for(size_t i = 0; i < capture->length; i++) {
     uint8_t str[9];
     for(size_t j = 0; j < 8; j++) {
-      if((packet_buffer[i] >> (7-j)) & 1) {
+      if((rts_capture_byte(capture, i) >> (7-j)) & 1) {
         str[j] = '1';
       } else {
         str[j] = '0';
@@ -151,148 +349,156 @@ static bool decodePacket(size_t received_bytes)
   printf("]\n");
   */
 
-  // The packet data received begins at a pretty specific location due to how
-  // the receiver is limited in setting preamble / syncword.
-  //
-  // +-----+     +-----+     +---------+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  // + hw1 +-----+ hw2 +-----+ swsync  +--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+---------
-  //          ^
-  //      buffer start
-  //
-  // Received buffer is oversampled with 4x due to the pretty ridiculous
-  // tolerance on the sent data.
-  //
-  // This means we need to stretch/shorten as needed in order to decode the
-  // actual packet bits.
-
-  memset(decoded_buffer, 0, sizeof(decoded_buffer));
-
-  size_t bit_index = 0;
-  size_t decoded_bit_index = 0;
-  size_t bit_distance = 0;
-
-  // Step 0: clean the packet buffer. Any pulse of 1 or 2 oversampled bits needs
-  // to be cleaned out.
-  for(size_t i = 0; i < received_bytes; i++) {
-    if(GET_BIT_AT(packet_buffer, i) == 0) {
-      if(GET_BIT_AT(packet_buffer, i+1) == 1 &&
-         GET_BIT_AT(packet_buffer, i+2) == 0 ) {
-         CLR_BIT_AT(packet_buffer, i+1);
-        i+=1;
-      }
-      if(GET_BIT_AT(packet_buffer, i+1) == 1 &&
-         GET_BIT_AT(packet_buffer, i+2) == 1 &&
-         GET_BIT_AT(packet_buffer, i+3) == 0 ) {
-        CLR_BIT_AT(packet_buffer, i+1);
-        CLR_BIT_AT(packet_buffer, i+2);
-        i+=2;
-      }
-    }
+  rts_decode_status_t status = rts_decode_capture(&decoder, capture);
+
+  // Unless the SW sync of a frame was found, the capture is noise or too weak
+  // for any other timing to help. Checked before the combiner takes the
+  // decoder over.
+  bool synced = false;
+  for(size_t i = 0; i < decoder.failed_count; i++) {
+    synced |= decoder.failed_start[i] != SIZE_MAX;
   }
+  uint16_t measured = rts_decoder_hw_sync(&decoder);
 
-  // Step 1: eat until rising edge of second HW pulse
-  bit_index += bits_until_next_edge(packet_buffer, bit_index);
+  // Frames which failed on their own may still vote a valid frame together
+  // with failed copies from earlier captures of the same press
+  if(status != RTS_DECODE_OK
+     && frame_combiner_add(&decoder, capture, packet->timestamp)) {
+    status = RTS_DECODE_OK;
+  }
 
-  // Step 2: eat until falling edge of second HW pulse
-  bit_index += bits_until_next_edge(packet_buffer, bit_index);
+  // Remotes running well fast or slow may need their own timing
+  if(status != RTS_DECODE_OK && synced && decodeTimed(capture, measured)) {
+    status = RTS_DECODE_OK;
+  }
 
-  // Step 3: eat until rising edge of SW sync
-  bit_index += bits_until_next_edge(packet_buffer, bit_index);
+  return status;
+}
 
-  // Step 4: eat until falling edge of SW sync and check the length matches
-  bit_distance = bits_until_next_edge(packet_buffer, bit_index);
-  if( bit_distance < 28 || bit_distance > 36 ) {
-      printf("Repeated packet\n");
+// Decode a failed capture again with the learned timing of the remotes most
+// likely to have sent it. 'measured' is the HW sync pulse length measured on
+// the capture, 0 if none was.
+static bool decodeTimed(const rts_capture_t* capture, uint16_t measured)
+{
+  uint16_t tried[TIMED_DECODE_MAX_TRIES];
+  size_t tries = 0;
+  const remote_t* remote;
 
-      // For a repeated packet, we need to eat 5 more hw pulses
-      for(size_t j = 0; j < 10; j++) {
-          bit_index += bits_until_next_edge(packet_buffer, bit_index);
-      }
-      bit_distance = bits_until_next_edge(packet_buffer, bit_index);
-  }
+  while(tries < TIMED_DECODE_MAX_TRIES
+        && (remote = nextTimed(measured, tried, tries)) != NULL) {
+    tried[tries++] = remote->hw_sync;
 
-  if( bit_distance < 28 || bit_distance > 36 ) {
-      printf("SW pulse length does not match\n");
-      return false;
-  }
+    rts_decoder_start(&decoder);
+    if(!rts_decoder_set_timing(&decoder, remote->hw_sync)) {
+      continue;
+    }
+    rts_decoder_feed(&decoder, capture);
+    if(rts_decoder_finish(&decoder) != RTS_DECODE_OK) {
+      continue;
+    }
 
-  bit_index += bits_until_next_edge(packet_buffer, bit_index);
-
-  // At this point, we have 4-5 periods of 'low' time from the SW sync, and then
-  // depending on whether the first bit is a 1 or 0, we might have more low time
-  bit_distance = bits_until_next_edge(packet_buffer, bit_index);
-  if(bit_distance > 5) {
-      // initial transition is a 0->1 (1)
-      SET_BIT_AT(decoded_buffer, decoded_bit_index);
-      // Move cursor to middle of manchester bit
-      bit_index += bits_until_next_edge(packet_buffer, bit_index);
-  } else {
-      // initial transition is a 1->0 (0)
-      CLR_BIT_AT(decoded_buffer, decoded_bit_index);
-      // Move cursor to middle of manchester bit
-      bit_index += bits_until_next_edge(packet_buffer, bit_index);
-      bit_index += bits_until_next_edge(packet_buffer, bit_index);
+    // Only a frame of a remote whose timing it was, or as good as, counts,
+    // anything else is more likely a fluke of the checksum
+    const remote_t* sender = remote_table_find(frameAddress(&decoder.frame));
+    if(sender != NULL && sender->hw_sync != 0
+       && timingOffset(sender->hw_sync, remote->hw_sync)
+          < TIMED_DECODE_MIN_OFFSET) {
+      return true;
+    }
   }
-  decoded_bit_index = 1;
-
-  while(decoded_bit_index < 56) {
-      // Manchester decoding is based on edge length + previous bit value
-      bit_distance = bits_until_next_edge(packet_buffer, bit_index);
-      if(GET_BIT_AT(decoded_buffer, decoded_bit_index - 1)) {
-          // Previous bit was a 1, so if next edge is @ 4 this bit is a 1 too
-          // If next edge is @ 8 the next bit is a 0
-          if(bit_distance >= 6) {
-              CLR_BIT_AT(decoded_buffer, decoded_bit_index);
-              // Next edge is another middle of manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-          } else {
-              SET_BIT_AT(decoded_buffer, decoded_bit_index);
-              // Next edge is start of next manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-              // Next edge is another middle of manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-          }
-      } else {
-          // Previous bit was a 0 (1->0), so if next edge is at 4 than the next
-          // bit is also a 0. If the next edge is significantly further than it
-          // is a 1
-          if(bit_distance >= 6) {
-              SET_BIT_AT(decoded_buffer, decoded_bit_index);
-              // Next edge is another middle of manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-          } else {
-              CLR_BIT_AT(decoded_buffer, decoded_bit_index);
-              // Next edge is start of next manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-              // Next edge is another middle of manchester bit
-              bit_index += bits_until_next_edge(packet_buffer, bit_index);
-          }
-      }
 
-      decoded_bit_index += 1;
+  return false;
+}
+
+// Paired remote whose learned timing is closest to 'measured', of those off
+// the nominal rate and off the 'tries' timings in 'tried'. NULL if there is
+// none.
+static const remote_t* nextTimed(uint16_t measured,
+                                 const uint16_t* tried,
+                                 size_t tries)
+{
+  const remote_t* best = NULL;
+  uint16_t best_offset = UINT16_MAX;
+
+  if(measured == 0) {
+    measured = RTS_HW_SYNC_NOMINAL;
   }
 
-  // De-'obfuscate' the packet
-  memcpy(packet_buffer, decoded_buffer, sizeof(decoded_buffer));
-  for(size_t i = 1; i < sizeof(decoded_buffer); i++) {
-    decoded_buffer[i] = packet_buffer[i] ^ packet_buffer[i - 1];
+  for(const remote_t* remote = remote_table_next(NULL);
+      remote != NULL;
+      remote = remote_table_next(remote)) {
+    if(remote->hw_sync == 0
+       || timingOffset(remote->hw_sync, RTS_HW_SYNC_NOMINAL)
+          < TIMED_DECODE_MIN_OFFSET) {
+      continue;
+    }
+
+    bool tried_already = false;
+    for(size_t i = 0; i < tries; i++) {
+      tried_already |= timingOffset(remote->hw_sync, tried[i])
+                       < TIMED_DECODE_MIN_OFFSET;
+    }
+
+    uint16_t offset = timingOffset(remote->hw_sync, measured);
+    if(!tried_already && offset < best_offset) {
+      best = remote;
+      best_offset = offset;
+    }
   }
 
-  // Check the 'checksum'
-  uint8_t cks = 0;
-  for(size_t i = 0; i < sizeof(decoded_buffer); i++) {
-    cks = cks ^ decoded_buffer[i] ^ (decoded_buffer[i] >> 4);
+  return best;
+}
+
+static uint16_t timingOffset(uint16_t a, uint16_t b)
+{
+  return a > b ? a - b : b - a;
+}
+
+static uint8_t eventFlags(const rx_packet_t* packet, const rts_frame_t* frame)
+{
+  uint8_t flags = 0;
+
+  if(frame->repeated) {
+    flags |= BRIDGE_EVENT_FLAG_REPEATED;
+  }
+  if(packet->status == RTS_DECODE_OK) {
+    flags |= BRIDGE_EVENT_FLAG_EARLY;
   }
-  if((cks & 0xf) != 0) {
-      printf("Checksum mismatch\n");
-      return false;
+  if(frame->combined) {
+    flags |= BRIDGE_EVENT_FLAG_COMBINED;
+  }
+  if(frame->repaired) {
+    flags |= BRIDGE_EVENT_FLAG_REPAIRED;
+  }
+
+  return flags;
+}
+
+static uint32_t frameAddress(const rts_frame_t* frame)
+{
+  return (uint32_t)frame->data[6] << 16 |
+         (uint32_t)frame->data[5] << 8 |
+         frame->data[4];
+}
+
+static bool checkDecode(const rx_packet_t* packet,
+                        rts_decode_status_t status,
+                        const rts_frame_t* frame)
+{
+  if(status != RTS_DECODE_OK) {
+    // The verdict says what went wrong (sync, truncation, pulse, checksum)
+    bridge_event_send_decode_error((uint8_t)status,
+                                   eventFlags(packet, frame),
+                                   packet->rssi,
+                                   packet->timestamp);
+    return false;
   }
 
   /*
   // debug: print packet content
   printf("Deobfuscated packet: [");
-  for(size_t i = 0; i < sizeof(decoded_buffer); i++) {
-    printf("%02x ", decoded_buffer[i]);
+  for(size_t i = 0; i < sizeof(frame->data); i++) {
+    printf("%02x ", frame->data[i]);
   }
   printf("]\n");
   */
@@ -300,44 +506,125 @@ static bool decodePacket(size_t received_bytes)
   return true;
 }
 
-static void parsePacket(void)
+static void parsePacket(const rx_packet_t* packet, const rts_frame_t* frame)
 {
   // Information contained in a packet:
   // * rolling code
   // * remote ID
   // * button pressed
-  uint32_t remote_address = decoded_buffer[6] << 16 |
-                            decoded_buffer[5] << 8 |
-                            decoded_buffer[4];
-  uint16_t rolling_code = decoded_buffer[2] << 8 | decoded_buffer[3];
-  uint8_t button = decoded_buffer[1] >> 4;
-
-  printf("From remote %06x (seq %u): ", remote_address, rolling_code);
-  switch(button) {
-    case 1:
-      printf("MY");
-      break;
-    case 2:
-      printf("UP");
-      break;
-    case 3:
-      printf("MY+UP");
-      break;
-    case 4:
-      printf("DOWN");
-      break;
-    case 5:
-      printf("MY+DOWN");
-      break;
-    case 6:
-      printf("UP+DOWN");
-      break;
-    case 7:
-      printf("MY+UP+DOWN");
-      break;
-    case 8:
-      printf("PROG");
-      break;
+
+  // Only Somfy RTS remotes are paired and drive the io remote
+  if(frame->protocol != RTS_PROTOCOL_SOMFY) {
+    return;
+  }
+
+  // A repeat of a frame which was already handled only makes its press last
+  // longer
+  if(frame->known) {
+    frame_cache_hold(frame, packet->timestamp);
+    return;
+  }
+
+  uint32_t remote_address = frameAddress(frame);
+  uint16_t rolling_code = frame->data[2] << 8 | frame->data[3];
+  uint8_t button = frame->data[1] >> 4;
+
+  // Neighbouring remotes are heard all the time, so turn them away first
+  const remote_t* remote = remote_table_find(remote_address);
+
+  if(learning && button == BUTTON_PROG) {
+    // PROG in learning mode pairs a new remote, or unpairs a known one
+    if(remote == NULL) {
+      if(remote_table_add(remote_address, rolling_code)) {
+        bridge_event_send_pairing(remote_address, true);
+      }
+    } else {
+      remote_table_remove(remote_address);
+      bridge_event_send_pairing(remote_address, false);
+    }
+    learning = false;
+    return;
+  }
+
+  // Each press must use up a fresh rolling code, anything else is a repeat
+  // of the last press or a replay
+  bool accepted = remote != NULL
+                  && remote_table_accept(remote, rolling_code,
+                                         packet->timestamp)
+                     == REMOTE_CODE_ACCEPTED;
+
+  // Whatever the verdict, repeats of this frame are recognised early from
+  // now on, unless the cache is full of held presses. Only the release of an
+  // accepted press is reported, and such a press is never pushed out by a
+  // neighbouring remote.
+  frame_cache_add(frame, packet->timestamp, accepted);
+  if(!accepted) {
+    return;
+  }
+
+  // Keep track of how fast the remote runs, for captures of it which fail
+  // at the nominal rate
+  remote_table_learn_timing(remote, frame->hw_sync);
+
+  // Queued behind any press still in progress, pressed and released by the
+  // timers, nothing to wait for here
+  actuator_queue_push(button & ACTUATOR_ALL, RAIL_GetTime());
+
+  bridge_event_frame_t event = {
+    .address = remote_address,
+    .rolling_code = rolling_code,
+    .button = button,
+    .flags = eventFlags(packet, frame),
+    .rssi = packet->rssi,
+    .timestamp = packet->timestamp,
+  };
+
+  bridge_event_send_frame(&event);
+}
+
+// Enter learning mode on request, and leave it again if nothing is paired
+// or unpaired in time
+static void updateLearning(void)
+{
+  if(learning_requested) {
+    learning_requested = false;
+    learning = true;
+    learning_start = RAIL_GetTime();
+  } else if(learning
+            && RAIL_GetTime() - learning_start > LEARNING_TIMEOUT_US) {
+    learning = false;
+  }
+}
+
+// Report packets the ISR could not hand over, log output that did not fit,
+// io remote commands the actuator queue had no room for and the number of
+// paired remotes, once there is room in the log to say so. Remotes paired
+// before a reset make the first report.
+static void reportDrops(void)
+{
+  rx_packet_queue_stats_t stats;
+  log_ring_stats_t log_stats;
+  actuator_queue_stats_t actuator_stats;
+  rx_packet_queue_get_stats(&stats);
+  log_ring_get_stats(&log_stats);
+  actuator_queue_get_stats(&actuator_stats);
+  size_t paired = remote_table_count();
+
+  if((stats.dropped != reported_drops
+      || lost_packets != reported_lost
+      || log_stats.dropped != reported_log_drops
+      || actuator_stats.dropped != reported_actuator_drops
+      || paired != reported_paired)
+     && log_stats.fill < LOG_RING_SIZE / 2
+     && bridge_event_send_drops(stats.dropped,
+                                lost_packets,
+                                log_stats.dropped,
+                                actuator_stats.dropped,
+                                (uint8_t) paired)) {
+    reported_drops = stats.dropped;
+    reported_lost = lost_packets;
+    reported_log_drops = log_stats.dropped;
+    reported_actuator_drops = actuator_stats.dropped;
+    reported_paired = paired;
   }
-  printf("\n");
 }
@@ -25,6 +25,9 @@
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
 // -----------------------------------------------------------------------------
+/// Captures are decoded while they are still being received, a chunk of this
+/// many bytes at a time (RX FIFO almost-full threshold above the fill level)
+#define RX_STREAM_CHUNK_BYTES 8
 
 // -----------------------------------------------------------------------------
 //                                Global Variables
@@ -115,7 +115,7 @@ const uint32_t Protocol_Configuration_modemConfigBase[] = {
   /*    1FFC */ 0x00000000UL,
   0x00020004UL, 0x00000000UL,
   /*    0008 */ 0x00000000UL,
-  0x00020018UL, 0x00000055UL,
+  0x00020018UL, 0x000000B3UL,
   /*    001C */ 0x00000000UL,
   0x00070028UL, 0x00000000UL,
   /*    002C */ 0x00000000UL,
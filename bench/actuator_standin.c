@@ -0,0 +1,28 @@
+/***************************************************************************//**
+ * @file actuator_standin.c
+ * @brief Host stand-in for the io remote button outputs used by app_process.c
+ *******************************************************************************
+ * There are no buttons to press on the host, so presses go nowhere.
+ ******************************************************************************/
+#include "actuator.h"
+
+static uint32_t hold_time_ms;
+
+void actuator_init(void)
+{
+}
+
+void actuator_set_hold_time(uint32_t hold_ms)
+{
+  hold_time_ms = hold_ms;
+}
+
+uint32_t actuator_get_hold_time(void)
+{
+  return hold_time_ms;
+}
+
+void actuator_press(uint8_t buttons)
+{
+  (void)buttons;
+}
@@ -0,0 +1,60 @@
+/***************************************************************************//**
+ * @file bench_app.c
+ * @brief Runs the application's decode and event reporting on the host
+ *******************************************************************************
+ * app_process.c is built as part of this file, so its static functions can be
+ * called directly. The RAIL stand-in in stubs/ and rail_standin.c covers what
+ * it needs from the radio.
+ ******************************************************************************/
+#include "../app_process.c"
+
+#include "bench_app.h"
+
+bool bench_app_decode(const rts_capture_t* capture, uint32_t timestamp)
+{
+  rx_packet_t packet = {
+    .handle = RAIL_RX_PACKET_HANDLE_INVALID,
+    .timestamp = timestamp,
+    .rssi = RAIL_RSSI_INVALID_DBM,
+    .status = RTS_DECODE_BUSY,
+  };
+  frame_cache_release_t release;
+
+  // Presses whose repeats have stopped are released first, as the main loop
+  // does between packets
+  while(frame_cache_expire(timestamp, &release)) {
+    bridge_event_send_release(release.address,
+                              release.button,
+                              release.repeats,
+                              release.held_us);
+  }
+
+  rts_decode_status_t status = decodePacket(&packet, capture);
+
+  if(!checkDecode(&packet, status, &decoder.frame)) {
+    return false;
+  }
+  parsePacket(&packet, &decoder.frame);
+  return true;
+}
+
+bool bench_app_receive(const uint8_t* data, size_t length)
+{
+  static bool started = false;
+
+  if(!started) {
+    // As app_init() does
+    RAIL_SetRxFifoThreshold(NULL, RX_STREAM_CHUNK_BYTES);
+    started = true;
+  }
+
+  // The radio writes the FIFO a byte at a time
+  bool held = rail_standin_receive(NULL, data, (uint16_t)length, 1);
+  app_process_action(NULL);
+  return !held;
+}
+
+const rts_frame_t* bench_app_frame(void)
+{
+  return &decoder.frame;
+}
@@ -0,0 +1,28 @@
+/***************************************************************************//**
+ * @file bench_app.h
+ * @brief Runs the application's decode and event reporting on the host
+ ******************************************************************************/
+#ifndef BENCH_APP_H
+#define BENCH_APP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rts_decoder.h"
+
+/// Decode and parse one capture the way app_process_action() does, as if it
+/// was received at RAIL time 'timestamp'. Presses released by then are
+/// reported first.
+bool bench_app_decode(const rts_capture_t* capture, uint32_t timestamp);
+
+/// Receive a capture through the RAIL stand-in, as the radio would hand it
+/// to the application, and run app_process_action() once it is in. Returns
+/// true if the application had its verdict before the capture was complete,
+/// and so never held it.
+bool bench_app_receive(const uint8_t* data, size_t length);
+
+/// Frame of the last decode
+const rts_frame_t* bench_app_frame(void);
+
+#endif // BENCH_APP_H
@@ -0,0 +1,495 @@
+/***************************************************************************//**
+ * @file bench_corpus.c
+ * @brief Capture corpus for the decoder benchmark
+ *******************************************************************************
+ * Synthetic captures follow the RTS timing as the receiver sees it: sampled at
+ * 6400 Hz, starting right after the syncword matched the first HW sync pulse.
+ ******************************************************************************/
+#include "bench_corpus.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// RTS timing, in microseconds
+#define SAMPLE_US     156.25
+#define HW_SYNC_US    2416.0
+#define SW_SYNC_US    4550.0
+#define HALF_BIT_US   604.0
+#define FRAME_GAP_US  30415.0
+// The syncword (0x00FFFF00) ends 8 samples into the low half of HW sync 1
+#define SYNCWORD_LOW_SAMPLES 8
+
+#define MAX_SEGMENTS  512
+
+// Glitches in each capture of a press at the edge of range
+#define MARGINAL_GLITCHES 10
+
+// Width of the glitch put in the sync pulses, in samples. The glitch filter
+// removes 1-2 sample glitches, so these all get through.
+#define SYNC_GLITCH_MIN 3
+#define SYNC_GLITCH_MAX 4
+
+// Pulses of a jammed channel are this many samples long, as another OOK
+// transmitter sending at about the RTS rate would key them
+#define NOISE_PULSE_MIN 3
+#define NOISE_PULSE_MAX 8
+
+typedef struct {
+  double duration;
+  unsigned int level;
+} segment_t;
+
+typedef struct {
+  segment_t segment[MAX_SEGMENTS];
+  size_t count;
+} waveform_t;
+
+static uint32_t prng_state;
+
+static uint32_t prng(void)
+{
+  // xorshift32, so the corpus is the same on every host
+  prng_state ^= prng_state << 13;
+  prng_state ^= prng_state >> 17;
+  prng_state ^= prng_state << 5;
+  return prng_state;
+}
+
+// Uniform in [-1, 1]
+static double prng_signed(void)
+{
+  return (prng() / 2147483647.5) - 1.0;
+}
+
+static bool reserve(bench_corpus_t* corpus, size_t extra)
+{
+  if(corpus->count + extra <= corpus->capacity) {
+    return true;
+  }
+
+  size_t capacity = corpus->capacity ? corpus->capacity : 64;
+  while(capacity < corpus->count + extra) {
+    capacity *= 2;
+  }
+
+  bench_capture_t* captures = realloc(corpus->captures,
+                                      capacity * sizeof(*captures));
+  if(captures == NULL) {
+    return false;
+  }
+
+  corpus->captures = captures;
+  corpus->capacity = capacity;
+  return true;
+}
+
+static void add_segment(waveform_t* wave, unsigned int level, double duration)
+{
+  if(wave->count < MAX_SEGMENTS) {
+    wave->segment[wave->count].level = level;
+    wave->segment[wave->count].duration = duration;
+    wave->count++;
+  }
+}
+
+static void add_frame(waveform_t* wave,
+                      const uint8_t raw[RTS_EXT_FRAME_BYTES],
+                      size_t bits,
+                      size_t hw_pulses,
+                      double scale)
+{
+  for(size_t i = 0; i < hw_pulses; i++) {
+    add_segment(wave, 1, HW_SYNC_US * scale);
+    add_segment(wave, 0, HW_SYNC_US * scale);
+  }
+  add_segment(wave, 1, SW_SYNC_US * scale);
+  add_segment(wave, 0, HALF_BIT_US * scale);
+
+  // Manchester: a 1 is a rising edge in the middle of the bit, a 0 a falling
+  for(size_t i = 0; i < bits; i++) {
+    unsigned int bit = (raw[i / 8] >> (7 - (i % 8))) & 1;
+    add_segment(wave, !bit, HALF_BIT_US * scale);
+    add_segment(wave, bit, HALF_BIT_US * scale);
+  }
+}
+
+static void seal_frame(uint8_t frame[RTS_EXT_FRAME_BYTES],
+                       uint8_t raw[RTS_EXT_FRAME_BYTES],
+                       size_t bytes);
+
+static void make_frame(uint8_t frame[RTS_EXT_FRAME_BYTES],
+                       uint8_t raw[RTS_EXT_FRAME_BYTES],
+                       size_t bytes)
+{
+  static const uint8_t buttons[] = { 0x1, 0x2, 0x4, 0x8 };
+  uint32_t address = prng() & 0xFFFFFF;
+  uint16_t rolling_code = (uint16_t) prng();
+
+  frame[0] = 0xA0 | (prng() & 0xF);
+  frame[1] = (uint8_t)(buttons[prng() % sizeof(buttons)] << 4);
+  frame[2] = (uint8_t)(rolling_code >> 8);
+  frame[3] = (uint8_t) rolling_code;
+  frame[4] = (uint8_t) address;
+  frame[5] = (uint8_t)(address >> 8);
+  frame[6] = (uint8_t)(address >> 16);
+  for(size_t i = RTS_FRAME_BYTES; i < RTS_EXT_FRAME_BYTES; i++) {
+    frame[i] = i < bytes ? (uint8_t) prng() : 0;
+  }
+
+  seal_frame(frame, raw, bytes);
+}
+
+// Fill in the checksum and obfuscate the first 'bytes' of the frame
+static void seal_frame(uint8_t frame[RTS_EXT_FRAME_BYTES],
+                       uint8_t raw[RTS_EXT_FRAME_BYTES],
+                       size_t bytes)
+{
+  uint8_t checksum = 0;
+  frame[1] &= 0xF0;
+  for(size_t i = 0; i < bytes; i++) {
+    checksum ^= frame[i] ^ (frame[i] >> 4);
+  }
+  frame[1] |= checksum & 0xF;
+
+  raw[0] = frame[0];
+  for(size_t i = 1; i < bytes; i++) {
+    raw[i] = frame[i] ^ raw[i - 1];
+  }
+}
+
+static void sample(const waveform_t* wave,
+                   double jitter,
+                   uint8_t capture[BENCH_CAPTURE_BYTES])
+{
+  double edge[MAX_SEGMENTS + 1];
+  double t = 0;
+
+  for(size_t i = 0; i < wave->count; i++) {
+    edge[i] = t + (i ? prng_signed() * jitter : 0);
+    t += wave->segment[i].duration;
+  }
+  edge[wave->count] = t;
+
+  memset(capture, 0, BENCH_CAPTURE_BYTES);
+  size_t segment = 0;
+  for(size_t i = 0; i < BENCH_CAPTURE_BYTES * 8; i++) {
+    double when = (i + 0.5) * SAMPLE_US;
+    while(segment + 1 < wave->count && edge[segment + 1] <= when) {
+      segment++;
+    }
+    if(wave->segment[segment].level) {
+      capture[i / 8] |= (uint8_t)(0x80 >> (i % 8));
+    }
+  }
+}
+
+static void add_glitches(uint8_t capture[BENCH_CAPTURE_BYTES],
+                         size_t glitches,
+                         size_t max_width)
+{
+  for(size_t i = 0; i < glitches; i++) {
+    size_t start = prng() % (BENCH_CAPTURE_BYTES * 8 - max_width);
+    size_t width = 1 + prng() % max_width;
+    for(size_t j = start; j < start + width; j++) {
+      capture[j / 8] ^= (uint8_t)(0x80 >> (j % 8));
+    }
+  }
+}
+
+// A frame and its first repeat, starting where the receiver starts capturing
+static void add_press(waveform_t* wave,
+                      const uint8_t raw[RTS_EXT_FRAME_BYTES],
+                      size_t bits,
+                      bool repeat,
+                      double scale)
+{
+  add_segment(wave, 0, HW_SYNC_US * scale - SYNCWORD_LOW_SAMPLES * SAMPLE_US);
+  add_frame(wave, raw, bits, repeat ? 6 : 1, scale);
+  add_segment(wave, 0, FRAME_GAP_US * scale);
+  add_frame(wave, raw, bits, 7, scale);
+  add_segment(wave, 0, FRAME_GAP_US * scale);
+}
+
+static void synthesize(bench_capture_t* out, bench_kind_t kind)
+{
+  uint8_t raw[RTS_EXT_FRAME_BYTES];
+  size_t bits = kind == BENCH_KIND_EXTENDED || kind == BENCH_KIND_EXTENDED_56
+                ? RTS_EXT_FRAME_BITS : RTS_FRAME_BITS;
+  waveform_t wave = { .count = 0 };
+  bool repeat = kind == BENCH_KIND_REPEAT || (prng() & 1);
+  double scale = 1.0 + prng_signed() * 0.02;
+  double jitter = 25.0;
+
+  if(kind == BENCH_KIND_FIRST) {
+    repeat = false;
+  } else if(kind == BENCH_KIND_DRIFT) {
+    scale = 1.0 + prng_signed() * 0.08;
+  } else if(kind == BENCH_KIND_GLITCH) {
+    jitter = 60.0;
+  }
+
+  make_frame(out->frame, raw, bits / 8);
+  if(kind == BENCH_KIND_EXTENDED_56) {
+    // Make the last 24 bits cancel out in the checksum, as they do in one
+    // extended frame in 16
+    uint8_t* extra = &out->frame[RTS_FRAME_BYTES];
+    uint8_t sum = (extra[0] ^ (extra[0] >> 4) ^ extra[1] ^ (extra[1] >> 4))
+                  & 0xF;
+    extra[2] = (uint8_t)((extra[2] & 0xF0) | (sum ^ (extra[2] >> 4)));
+    seal_frame(out->frame, raw, RTS_EXT_FRAME_BYTES);
+  }
+  out->has_frame = true;
+  out->bits = bits;
+  out->kind = kind;
+  out->length = BENCH_CAPTURE_BYTES;
+
+  add_press(&wave, raw, bits, repeat, scale);
+  sample(&wave, jitter, out->capture);
+  if(kind == BENCH_KIND_GLITCH) {
+    add_glitches(out->capture, 1 + prng() % 4, 2);
+  } else if(kind == BENCH_KIND_SYNC) {
+    // Anywhere in the sync pulses ahead of the first frame, up to the end of
+    // its SW sync
+    size_t hw_pulses = repeat ? 6 : 1;
+    double sync_us = HW_SYNC_US * scale - SYNCWORD_LOW_SAMPLES * SAMPLE_US
+                     + (2 * hw_pulses * HW_SYNC_US + SW_SYNC_US) * scale;
+    size_t width = SYNC_GLITCH_MIN
+                   + prng() % (SYNC_GLITCH_MAX - SYNC_GLITCH_MIN + 1);
+    size_t start = prng() % ((size_t)(sync_us / SAMPLE_US) - width);
+    for(size_t i = start; i < start + width; i++) {
+      out->capture[i / 8] ^= (uint8_t)(0x80 >> (i % 8));
+    }
+  }
+}
+
+// One capture of a jammed channel, where another transmitter keys the carrier
+// with no frame in it
+static void synthesize_noise(bench_capture_t* out)
+{
+  waveform_t wave = { .count = 0 };
+  double us = 0;
+
+  memset(out->frame, 0, RTS_EXT_FRAME_BYTES);
+  out->has_frame = false;
+  out->bits = 0;
+  out->kind = BENCH_KIND_NOISE;
+  out->length = BENCH_CAPTURE_BYTES;
+
+  for(unsigned int level = 0; us < BENCH_CAPTURE_BYTES * 8 * SAMPLE_US;
+      level ^= 1) {
+    size_t samples = NOISE_PULSE_MIN
+                     + prng() % (NOISE_PULSE_MAX - NOISE_PULSE_MIN + 1);
+    add_segment(&wave, level, samples * SAMPLE_US);
+    us += samples * SAMPLE_US;
+  }
+  sample(&wave, 25.0, out->capture);
+}
+
+// One capture of a press received at the edge of range, where glitches come
+// often and some are too wide for the glitch filter
+static void synthesize_marginal(bench_capture_t* out,
+                                const uint8_t frame[RTS_EXT_FRAME_BYTES],
+                                const uint8_t raw[RTS_EXT_FRAME_BYTES],
+                                bool repeat)
+{
+  waveform_t wave = { .count = 0 };
+  double scale = 1.0 + prng_signed() * 0.02;
+
+  memcpy(out->frame, frame, RTS_EXT_FRAME_BYTES);
+  out->has_frame = true;
+  out->bits = RTS_FRAME_BITS;
+  out->kind = BENCH_KIND_GLITCH;
+  out->length = BENCH_CAPTURE_BYTES;
+
+  add_press(&wave, raw, RTS_FRAME_BITS, repeat, scale);
+  sample(&wave, 60.0, out->capture);
+  add_glitches(out->capture, MARGINAL_GLITCHES, 3);
+}
+
+// One capture of a press from a remote running at 'scale' times the nominal
+// pulse lengths, with a few glitches
+static void synthesize_scaled(bench_capture_t* out,
+                              const uint8_t frame[RTS_EXT_FRAME_BYTES],
+                              const uint8_t raw[RTS_EXT_FRAME_BYTES],
+                              double scale)
+{
+  waveform_t wave = { .count = 0 };
+
+  memcpy(out->frame, frame, RTS_EXT_FRAME_BYTES);
+  out->has_frame = true;
+  out->bits = RTS_FRAME_BITS;
+  out->kind = BENCH_KIND_GLITCH;
+  out->length = BENCH_CAPTURE_BYTES;
+
+  add_press(&wave, raw, RTS_FRAME_BITS, false, scale);
+  sample(&wave, 60.0, out->capture);
+  add_glitches(out->capture, 1 + prng() % 4, 2);
+}
+
+const char* bench_kind_name(bench_kind_t kind)
+{
+  static const char* names[BENCH_KIND_COUNT] = {
+    "first", "repeat", "glitch", "drift", "extended", "extended_56", "sync",
+    "noise", "recorded"
+  };
+  return kind < BENCH_KIND_COUNT ? names[kind] : "unknown";
+}
+
+bool bench_corpus_add_synthetic(bench_corpus_t* corpus,
+                                size_t count,
+                                uint32_t seed)
+{
+  if(!reserve(corpus, count * BENCH_KIND_RECORDED)) {
+    return false;
+  }
+
+  prng_state = seed ? seed : 1;
+  for(size_t i = 0; i < count; i++) {
+    for(bench_kind_t kind = 0; kind < BENCH_KIND_EXTENDED; kind++) {
+      synthesize(&corpus->captures[corpus->count++], kind);
+    }
+  }
+  // Extended frames last, so the other kinds come out as they always have
+  for(size_t i = 0; i < count; i++) {
+    synthesize(&corpus->captures[corpus->count++], BENCH_KIND_EXTENDED);
+  }
+  for(size_t i = 0; i < count; i++) {
+    synthesize(&corpus->captures[corpus->count++], BENCH_KIND_SYNC);
+  }
+  for(size_t i = 0; i < count; i++) {
+    synthesize_noise(&corpus->captures[corpus->count++]);
+  }
+  for(size_t i = 0; i < count; i++) {
+    synthesize(&corpus->captures[corpus->count++], BENCH_KIND_EXTENDED_56);
+  }
+  return true;
+}
+
+bool bench_corpus_add_marginal(bench_corpus_t* corpus,
+                               size_t presses,
+                               size_t copies,
+                               uint32_t seed)
+{
+  if(!reserve(corpus, presses * copies)) {
+    return false;
+  }
+
+  prng_state = seed ? seed : 1;
+  for(size_t i = 0; i < presses; i++) {
+    uint8_t frame[RTS_EXT_FRAME_BYTES];
+    uint8_t raw[RTS_EXT_FRAME_BYTES];
+    make_frame(frame, raw, RTS_FRAME_BYTES);
+    for(size_t copy = 0; copy < copies; copy++) {
+      synthesize_marginal(&corpus->captures[corpus->count++],
+                          frame, raw, copy > 0);
+    }
+  }
+  return true;
+}
+
+bool bench_corpus_add_remote(bench_corpus_t* corpus,
+                             size_t presses,
+                             double scale,
+                             uint32_t seed)
+{
+  if(!reserve(corpus, presses)) {
+    return false;
+  }
+
+  prng_state = seed ? seed : 1;
+  uint8_t frame[RTS_EXT_FRAME_BYTES];
+  uint8_t raw[RTS_EXT_FRAME_BYTES];
+  make_frame(frame, raw, RTS_FRAME_BYTES);
+
+  for(size_t i = 0; i < presses; i++) {
+    uint16_t rolling_code = (uint16_t)((frame[2] << 8 | frame[3]) + 1);
+    frame[2] = (uint8_t)(rolling_code >> 8);
+    frame[3] = (uint8_t) rolling_code;
+    seal_frame(frame, raw, RTS_FRAME_BYTES);
+    synthesize_scaled(&corpus->captures[corpus->count++], frame, raw, scale);
+  }
+  return true;
+}
+
+// Parse one capture line, returns its length in bytes, 0 if it holds no
+// capture
+static size_t parse_line(const char* line,
+                         uint8_t capture[BENCH_CAPTURE_BYTES])
+{
+  size_t bits = 0;
+  const char* dump = strstr(line, "b'[");
+
+  memset(capture, 0, BENCH_CAPTURE_BYTES);
+
+  if(dump != NULL) {
+    for(const char* c = dump + 3; *c && *c != ']'; c++) {
+      if(*c != '0' && *c != '1') {
+        continue;
+      }
+      if(bits < BENCH_CAPTURE_BYTES * 8 && *c == '1') {
+        capture[bits / 8] |= (uint8_t)(0x80 >> (bits % 8));
+      }
+      bits++;
+    }
+  } else {
+    int high = -1;
+    for(const char* c = line; *c && *c != '#'; c++) {
+      if(!isxdigit((unsigned char) *c)) {
+        continue;
+      }
+      int nibble = isdigit((unsigned char) *c) ? *c - '0'
+                   : tolower((unsigned char) *c) - 'a' + 10;
+      if(high < 0) {
+        high = nibble;
+      } else {
+        if(bits < BENCH_CAPTURE_BYTES * 8) {
+          capture[bits / 8] = (uint8_t)((high << 4) | nibble);
+        }
+        bits += 8;
+        high = -1;
+      }
+    }
+  }
+
+  if(bits < BENCH_RECORDED_MIN_BYTES * 8) {
+    return 0;
+  }
+  return bits < BENCH_CAPTURE_BYTES * 8 ? bits / 8 : BENCH_CAPTURE_BYTES;
+}
+
+bool bench_corpus_add_file(bench_corpus_t* corpus, const char* path)
+{
+  FILE* file = fopen(path, "r");
+  if(file == NULL) {
+    return false;
+  }
+
+  char line[8192];
+  while(fgets(line, sizeof(line), file) != NULL) {
+    if(!reserve(corpus, 1)) {
+      fclose(file);
+      return false;
+    }
+
+    bench_capture_t* out = &corpus->captures[corpus->count];
+    out->length = parse_line(line, out->capture);
+    if(out->length > 0) {
+      out->has_frame = false;
+      out->kind = BENCH_KIND_RECORDED;
+      corpus->count++;
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+void bench_corpus_free(bench_corpus_t* corpus)
+{
+  free(corpus->captures);
+  corpus->captures = NULL;
+  corpus->count = 0;
+  corpus->capacity = 0;
+}
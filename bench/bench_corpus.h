@@ -0,0 +1,77 @@
+/***************************************************************************//**
+ * @file bench_corpus.h
+ * @brief Capture corpus for the decoder benchmark
+ ******************************************************************************/
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rts_decoder.h"
+
+/// Size of a capture as configured in the radio (FIXED_LENGTH_SIZE)
+#define BENCH_CAPTURE_BYTES 180
+/// Recorded captures may be shorter, from before the capture was lengthened
+/// to hold a repeat frame too
+#define BENCH_RECORDED_MIN_BYTES 86
+
+/// Kind of capture, results are reported per kind
+typedef enum {
+  BENCH_KIND_FIRST = 0,   ///< First frame of a press, 2 HW sync pulses
+  BENCH_KIND_REPEAT,      ///< Repeat frame, 7 HW sync pulses
+  BENCH_KIND_GLITCH,      ///< Like the above, with 1-2 sample glitches added
+  BENCH_KIND_DRIFT,       ///< Remote clock up to 8% off nominal
+  BENCH_KIND_EXTENDED,    ///< Extended (80-bit) frame, first or repeat
+  BENCH_KIND_EXTENDED_56, ///< Extended frame whose first 56 bits pass alone
+  BENCH_KIND_SYNC,        ///< A glitch too wide to filter in the sync pulses
+  BENCH_KIND_NOISE,       ///< Jammed channel, pulses of random length only
+  BENCH_KIND_RECORDED,    ///< Loaded from a file, expected frame unknown
+  BENCH_KIND_COUNT
+} bench_kind_t;
+
+typedef struct {
+  uint8_t capture[BENCH_CAPTURE_BYTES];
+  size_t length;                    ///< Bytes used in 'capture'
+  uint8_t frame[RTS_EXT_FRAME_BYTES]; ///< Expected frame, if has_frame
+  size_t bits;                      ///< Bits in the expected frame
+  bool has_frame;
+  bench_kind_t kind;
+} bench_capture_t;
+
+typedef struct {
+  bench_capture_t* captures;
+  size_t count;
+  size_t capacity;
+} bench_corpus_t;
+
+/// Name of a capture kind, as used in the JSON report
+const char* bench_kind_name(bench_kind_t kind);
+
+/// Add 'count' synthetic captures of every synthetic kind, from 'seed'
+bool bench_corpus_add_synthetic(bench_corpus_t* corpus,
+                                size_t count,
+                                uint32_t seed);
+
+/// Add 'presses' presses received at the edge of range, from 'seed'. Each
+/// press is 'copies' consecutive captures of the same frame.
+bool bench_corpus_add_marginal(bench_corpus_t* corpus,
+                               size_t presses,
+                               size_t copies,
+                               uint32_t seed);
+
+/// Add one capture of each of 'presses' consecutive presses of a single remote,
+/// with pulses 'scale' times their nominal length, from 'seed'
+bool bench_corpus_add_remote(bench_corpus_t* corpus,
+                             size_t presses,
+                             double scale,
+                             uint32_t seed);
+
+/// Add recorded captures from a file. Each line holds one capture, either as
+/// hex bytes or as the "Packet received: b'[...]" debug dump of app_process.c.
+bool bench_corpus_add_file(bench_corpus_t* corpus, const char* path);
+
+void bench_corpus_free(bench_corpus_t* corpus);
+
+#endif // BENCH_CORPUS_H
@@ -0,0 +1,643 @@
+/***************************************************************************//**
+ * @file bench_decoder.c
+ * @brief Host benchmark for the RTS decoder
+ *******************************************************************************
+ * Replays a corpus of synthetic and recorded captures through the decoder and
+ * reports ns/frame, frames/s, the split of decode time over the decoder
+ * stages, the decode results per kind of capture, and how early a verdict is
+ * known when the captures are streamed in FIFO-sized chunks, both to the
+ * decoder and through the application and the RAIL stand-in. The report is
+ * written as JSON so it can be diffed between revisions. The run fails if an
+ * extended frame whose first 56 bits pass the checksum on their own does not
+ * decode to all 80 bits.
+ *
+ * Usage: bench_decoder [-n captures] [-s seed] [-t seconds] [-o report.json]
+ *                      [recorded captures ...]
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "rts_decoder.h"
+#include "app_process.h"
+#include "bench_app.h"
+#include "bench_corpus.h"
+#include "remote_table.h"
+
+// Same decoder, built with RTS_DECODER_PROFILE (see Makefile)
+rts_decode_status_t rts_decode_capture_profiled(rts_decoder_t* decoder,
+                                                const rts_capture_t* capture);
+
+// Room for every rts_decode_status_t value
+#define STATUS_COUNT 16
+
+typedef struct {
+  size_t count;
+  size_t wrong;
+  size_t repaired;        ///< Frames which only decoded after a repair
+  size_t status[STATUS_COUNT];
+} kind_result_t;
+
+typedef struct {
+  double ns_per_frame;
+  size_t iterations;
+} timing_t;
+
+typedef struct {
+  size_t mismatches;      ///< Verdict or frame differs from a whole decode
+  size_t early;           ///< Verdict known before the end of the capture
+  double verdict_bytes;   ///< Mean capture bytes fed up to the verdict
+  size_t app_early;       ///< Frames the application took over that early
+} stream_result_t;
+
+typedef struct {
+  timing_t timing;        ///< Time per repeat, first frames not included
+  size_t repeats;         ///< Repeats decoded
+  size_t known;           ///< Repeats which stopped at the frame lookup
+} repeat_result_t;
+
+// Repeats decoded after each capture, as sent while a button is held
+#define REPEATS_PER_PRESS 4
+
+typedef struct {
+  size_t presses;
+  size_t alone;           ///< Presses with a capture that decodes on its own
+  size_t decoded;         ///< Presses the application decoded, combining too
+  size_t combined;        ///< Frames voted together from failed frames
+  size_t wrong;           ///< Combined frames other than the one sent
+} combine_result_t;
+
+// Presses at the edge of range, and captures of each
+#define MARGINAL_PRESSES 200
+#define MARGINAL_COPIES  3
+// RAIL time between the captures of a press, and between presses
+#define CAPTURE_INTERVAL_US 250000UL
+#define PRESS_INTERVAL_US   5000000UL
+
+typedef struct {
+  size_t presses;         ///< Presses replayed once the timing was learned
+  size_t alone;           ///< Presses which decode right at the nominal rate
+  size_t decoded;         ///< Presses the application decoded right
+  unsigned int hw_sync;   ///< Learned HW sync pulse length, 1/32 samples
+} learn_result_t;
+
+// A remote whose pulses are 12% short, and the presses of it replayed to
+// learn its timing, and again after that
+#define FAST_REMOTE_SCALE 0.88
+#define LEARN_PRESSES     500
+// Every this many other paired remotes runs off the nominal rate as well, at
+// one of these HW sync pulse lengths (1/32 samples)
+#define OFF_RATE_EVERY    8
+#define OFF_RATE_COUNT    4
+static const uint16_t off_rate[OFF_RATE_COUNT] = { 460, 470, 530, 540 };
+
+static const char* stage_names[RTS_STAGE_COUNT] = {
+  "run_extraction", "glitch_filter", "sync_search", "manchester", "checksum"
+};
+
+// Decoder verdicts in the order they are reported
+static const rts_decode_status_t reported_status[] = {
+  RTS_DECODE_OK,
+  RTS_DECODE_NO_SYNC,
+  RTS_DECODE_TRUNCATED,
+  RTS_DECODE_BAD_PULSE,
+  RTS_DECODE_CHECKSUM,
+};
+#define REPORTED_STATUS_COUNT \
+  (sizeof(reported_status) / sizeof(reported_status[0]))
+
+// Every this many captures is split in two, the way RAIL hands out a packet
+// that wraps around the end of the RX FIFO
+#define SPLIT_EVERY 6
+
+static rts_decoder_t decoder;
+static volatile size_t sink;
+
+// Profiling state, fed by rts_decoder_profile_stage()
+static uint64_t stage_ticks[RTS_STAGE_COUNT];
+static uint64_t stage_exits[RTS_STAGE_COUNT];
+static rts_decoder_stage_t current_stage;
+static uint64_t stage_start;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return now_ns();
+#endif
+}
+
+void rts_decoder_profile_stage(rts_decoder_stage_t stage)
+{
+  uint64_t t = ticks();
+  stage_ticks[current_stage] += t - stage_start;
+  stage_exits[current_stage]++;
+  current_stage = stage;
+  stage_start = t;
+}
+
+static const char* status_name(size_t status)
+{
+  switch(status) {
+    case RTS_DECODE_BUSY:      return "busy";
+    case RTS_DECODE_OK:        return "ok";
+    case RTS_DECODE_NO_SYNC:   return "no_sync";
+    case RTS_DECODE_TRUNCATED: return "truncated";
+    case RTS_DECODE_BAD_PULSE: return "bad_pulse";
+    case RTS_DECODE_CHECKSUM:  return "checksum";
+    default:                   return "other";
+  }
+}
+
+// View of corpus capture 'index' as the decoder would get it from the FIFO
+static rts_capture_t capture_view(const bench_corpus_t* corpus, size_t index)
+{
+  const uint8_t* data = corpus->captures[index].capture;
+  size_t length = corpus->captures[index].length;
+  size_t split = length;
+
+  if(index % SPLIT_EVERY == 0) {
+    split = (index / SPLIT_EVERY) % length;
+  }
+
+  rts_capture_t view = {
+    .first = data,
+    .first_length = split,
+    .last = data + split,
+    .length = length,
+  };
+  return view;
+}
+
+static void classify(const bench_corpus_t* corpus,
+                     kind_result_t result[BENCH_KIND_COUNT])
+{
+  memset(result, 0, sizeof(kind_result_t) * BENCH_KIND_COUNT);
+
+  for(size_t i = 0; i < corpus->count; i++) {
+    const bench_capture_t* capture = &corpus->captures[i];
+    kind_result_t* r = &result[capture->kind];
+    rts_capture_t view = capture_view(corpus, i);
+    rts_decode_status_t status = rts_decode_capture(&decoder, &view);
+    r->count++;
+    r->status[status < STATUS_COUNT ? status : RTS_DECODE_BUSY]++;
+    r->repaired += status == RTS_DECODE_OK && decoder.frame.repaired;
+    if(status == RTS_DECODE_OK && capture->has_frame
+       && (decoder.frame.bits != capture->bits
+           || memcmp(decoder.frame.data, capture->frame,
+                     capture->bits / 8) != 0)) {
+      r->wrong++;
+    }
+  }
+}
+
+// Feed every capture to the decoder a chunk at a time, and check the result
+// against decoding it in one go
+static void stream(const bench_corpus_t* corpus, stream_result_t* result)
+{
+  static rts_decoder_t whole;
+  size_t verdict_bytes = 0;
+
+  memset(result, 0, sizeof(*result));
+
+  for(size_t i = 0; i < corpus->count; i++) {
+    rts_capture_t view = capture_view(corpus, i);
+    rts_decode_status_t expected = rts_decode_capture(&whole, &view);
+    rts_decode_status_t status = RTS_DECODE_BUSY;
+    size_t length = view.length;
+
+    rts_decoder_start(&decoder);
+    for(view.length = 0; view.length < length && status == RTS_DECODE_BUSY;) {
+      view.length += RX_STREAM_CHUNK_BYTES;
+      if(view.length > length) {
+        view.length = length;
+      }
+      status = rts_decoder_feed(&decoder, &view);
+    }
+    if(status == RTS_DECODE_BUSY) {
+      status = rts_decoder_finish(&decoder);
+    } else if(view.length < length) {
+      result->early++;
+    }
+    verdict_bytes += view.length;
+
+    if(status != expected
+       || memcmp(&decoder.frame, &whole.frame, sizeof(whole.frame)) != 0) {
+      result->mismatches++;
+    }
+  }
+
+  result->verdict_bytes = (double) verdict_bytes / corpus->count;
+}
+
+// Receive every capture through the application, back to back, and count
+// those it had decoded before they were complete. Captures which fail are
+// held for the main loop either way. The RX FIFO fill level carries over from
+// one capture to the next, as it does on the radio.
+static void stream_app(const bench_corpus_t* corpus, stream_result_t* result)
+{
+  result->app_early = 0;
+  for(size_t i = 0; i < corpus->count; i++) {
+    const bench_capture_t* capture = &corpus->captures[i];
+    result->app_early += bench_app_receive(capture->capture, capture->length);
+  }
+}
+
+static timing_t time_decoder(const bench_corpus_t* corpus, double min_seconds)
+{
+  timing_t timing = { 0, 0 };
+  uint64_t start = now_ns();
+  uint64_t elapsed;
+
+  do {
+    for(size_t i = 0; i < corpus->count; i++) {
+      rts_capture_t view = capture_view(corpus, i);
+      sink += rts_decode_capture(&decoder, &view);
+    }
+    timing.iterations++;
+    elapsed = now_ns() - start;
+  } while(elapsed < min_seconds * 1e9);
+
+  timing.ns_per_frame = (double) elapsed
+                        / ((double) timing.iterations * corpus->count);
+  return timing;
+}
+
+static timing_t time_app(const bench_corpus_t* corpus, double min_seconds)
+{
+  timing_t timing = { 0, 0 };
+  uint32_t now = 0;
+  uint64_t start = now_ns();
+  uint64_t elapsed;
+
+  do {
+    for(size_t i = 0; i < corpus->count; i++) {
+      rts_capture_t view = capture_view(corpus, i);
+      sink += bench_app_decode(&view, now);
+      now += PRESS_INTERVAL_US;
+    }
+    timing.iterations++;
+    elapsed = now_ns() - start;
+  } while(elapsed < min_seconds * 1e9);
+
+  timing.ns_per_frame = (double) elapsed
+                        / ((double) timing.iterations * corpus->count);
+  return timing;
+}
+
+// Decode and parse each capture, then its repeats while the first one is still
+// remembered, and time only the repeats
+static void time_repeats(const bench_corpus_t* corpus,
+                         double min_seconds,
+                         repeat_result_t* result)
+{
+  uint64_t repeat_ns = 0;
+  uint64_t deadline = now_ns() + (uint64_t)(min_seconds * 1e9);
+  uint32_t now = 0;
+
+  memset(result, 0, sizeof(*result));
+
+  do {
+    for(size_t i = 0; i < corpus->count; i++) {
+      rts_capture_t view = capture_view(corpus, i);
+      sink += bench_app_decode(&view, now);
+
+      uint64_t start = now_ns();
+      for(size_t r = 0; r < REPEATS_PER_PRESS; r++) {
+        now += CAPTURE_INTERVAL_US;
+        sink += bench_app_decode(&view, now);
+        result->known += bench_app_frame()->known;
+      }
+      repeat_ns += now_ns() - start;
+      result->repeats += REPEATS_PER_PRESS;
+      now += PRESS_INTERVAL_US;
+    }
+    result->timing.iterations++;
+  } while(now_ns() < deadline);
+
+  result->timing.ns_per_frame = (double) repeat_ns / result->repeats;
+}
+
+// Replay presses at the edge of range through the application, and see how
+// many of them it gets, against how many a single capture would get
+static void combine(const bench_corpus_t* presses, combine_result_t* result)
+{
+  uint32_t now = 0;
+
+  memset(result, 0, sizeof(*result));
+
+  for(size_t first = 0; first < presses->count; first += MARGINAL_COPIES) {
+    bool alone = false;
+    bool decoded = false;
+
+    for(size_t i = first; i < first + MARGINAL_COPIES; i++) {
+      rts_capture_t view = capture_view(presses, i);
+      alone |= rts_decode_capture(&decoder, &view) == RTS_DECODE_OK;
+
+      if(bench_app_decode(&view, now)) {
+        const rts_frame_t* frame = bench_app_frame();
+        decoded = true;
+        if(frame->combined) {
+          result->combined++;
+          if(memcmp(frame->data, presses->captures[i].frame,
+                    RTS_FRAME_BYTES) != 0) {
+            result->wrong++;
+          }
+        }
+      }
+      now += CAPTURE_INTERVAL_US;
+    }
+
+    result->presses++;
+    result->alone += alone;
+    result->decoded += decoded;
+    now += PRESS_INTERVAL_US;
+  }
+}
+
+// Let the application learn the timing of a fast remote, and see how many of
+// its presses get through after that, against how many decode at the
+// nominal rate
+static bool learn(uint32_t seed, learn_result_t* result)
+{
+  bench_corpus_t presses = { 0 };
+  uint32_t now = 0;
+
+  memset(result, 0, sizeof(*result));
+  if(!bench_corpus_add_remote(&presses, 2 * LEARN_PRESSES,
+                              FAST_REMOTE_SCALE, seed)) {
+    return false;
+  }
+
+  // Make room for the remote in the full table, behind all the others. Some
+  // of those run off the nominal rate too, but not as fast as this one.
+  const uint8_t* frame = presses.captures[0].frame;
+  uint32_t address = (uint32_t)frame[6] << 16 | frame[5] << 8 | frame[4];
+  const remote_t* last = NULL;
+  size_t index = 0;
+  for(const remote_t* remote = remote_table_next(NULL); remote != NULL;
+      remote = remote_table_next(remote), index++) {
+    for(size_t i = 0; index % OFF_RATE_EVERY == 0 && i < LEARN_PRESSES; i++) {
+      remote_table_learn_timing(
+        remote, off_rate[(index / OFF_RATE_EVERY) % OFF_RATE_COUNT]);
+    }
+    last = remote;
+  }
+  if(last != NULL) {
+    remote_table_remove(last->address);
+  }
+  remote_table_add(address, (uint16_t)(frame[2] << 8 | frame[3]) - 1);
+
+  for(size_t i = 0; i < presses.count; i++) {
+    rts_capture_t view = capture_view(&presses, i);
+    bool decoded = bench_app_decode(&view, now)
+                   && memcmp(bench_app_frame()->data,
+                             presses.captures[i].frame, RTS_FRAME_BYTES) == 0;
+    if(i >= LEARN_PRESSES) {
+      result->presses++;
+      result->decoded += decoded;
+      result->alone += rts_decode_capture(&decoder, &view) == RTS_DECODE_OK
+                       && memcmp(decoder.frame.data, presses.captures[i].frame,
+                                 RTS_FRAME_BYTES) == 0;
+    }
+    now += PRESS_INTERVAL_US;
+  }
+
+  const remote_t* remote = remote_table_find(address);
+  result->hw_sync = remote != NULL ? remote->hw_sync : 0;
+  bench_corpus_free(&presses);
+  return true;
+}
+
+// Share of decode time spent in each stage. Every stage switch costs a tick
+// read, which is measured up front and taken out again.
+static void profile_stages(const bench_corpus_t* corpus,
+                           double min_seconds,
+                           double share[RTS_STAGE_COUNT])
+{
+  const size_t calibration_rounds = 1000000;
+  uint64_t start = ticks();
+  for(size_t i = 0; i < calibration_rounds; i++) {
+    rts_decoder_profile_stage((rts_decoder_stage_t)(i % RTS_STAGE_COUNT));
+  }
+  double overhead = (double)(ticks() - start) / calibration_rounds;
+
+  memset(stage_ticks, 0, sizeof(stage_ticks));
+  memset(stage_exits, 0, sizeof(stage_exits));
+
+  uint64_t deadline = now_ns() + (uint64_t)(min_seconds * 1e9);
+  do {
+    for(size_t i = 0; i < corpus->count; i++) {
+      stage_start = ticks();
+      current_stage = RTS_STAGE_RUN_EXTRACTION;
+      rts_capture_t view = capture_view(corpus, i);
+      sink += rts_decode_capture_profiled(&decoder, &view);
+      rts_decoder_profile_stage(RTS_STAGE_RUN_EXTRACTION);
+    }
+  } while(now_ns() < deadline);
+
+  double total = 0;
+  for(size_t i = 0; i < RTS_STAGE_COUNT; i++) {
+    double net = (double) stage_ticks[i] - overhead * stage_exits[i];
+    share[i] = net > 0 ? net : 0;
+    total += share[i];
+  }
+  for(size_t i = 0; i < RTS_STAGE_COUNT; i++) {
+    share[i] = total > 0 ? share[i] / total : 0;
+  }
+}
+
+static void write_report(FILE* out,
+                         const bench_corpus_t* corpus,
+                         uint32_t seed,
+                         const timing_t* decode,
+                         const timing_t* app,
+                         const double share[RTS_STAGE_COUNT],
+                         const kind_result_t result[BENCH_KIND_COUNT],
+                         const stream_result_t* streamed,
+                         const repeat_result_t* repeated,
+                         const combine_result_t* combined,
+                         const learn_result_t* learned)
+{
+  fprintf(out, "{\n");
+  fprintf(out, "  \"corpus\": {\"seed\": %u, \"captures\": %zu},\n",
+          seed, corpus->count);
+  fprintf(out, "  \"decode\": {\"ns_per_frame\": %.1f, \"frames_per_s\": %.0f},\n",
+          decode->ns_per_frame, 1e9 / decode->ns_per_frame);
+  fprintf(out, "  \"decode_and_parse\": {\"ns_per_frame\": %.1f, "
+               "\"frames_per_s\": %.0f},\n",
+          app->ns_per_frame, 1e9 / app->ns_per_frame);
+
+  fprintf(out, "  \"repeats\": {\"ns_per_frame\": %.1f, "
+               "\"frames_per_s\": %.0f, \"known_share\": %.3f},\n",
+          repeated->timing.ns_per_frame, 1e9 / repeated->timing.ns_per_frame,
+          (double) repeated->known / repeated->repeats);
+
+  fprintf(out, "  \"stages\": {\n");
+  for(size_t i = 0; i < RTS_STAGE_COUNT; i++) {
+    fprintf(out, "    \"%s\": {\"share\": %.3f, \"ns_per_frame\": %.1f}%s\n",
+            stage_names[i], share[i], share[i] * decode->ns_per_frame,
+            i + 1 < RTS_STAGE_COUNT ? "," : "");
+  }
+  fprintf(out, "  },\n");
+
+  fprintf(out, "  \"streaming\": {\"chunk_bytes\": %d, \"capture_bytes\": %d, "
+               "\"verdict_bytes\": %.1f, \"early\": %zu, "
+               "\"mismatches\": %zu, \"app_early\": %zu},\n",
+          RX_STREAM_CHUNK_BYTES, BENCH_CAPTURE_BYTES, streamed->verdict_bytes,
+          streamed->early, streamed->mismatches, streamed->app_early);
+
+  fprintf(out, "  \"combining\": {\"presses\": %zu, \"alone\": %zu, "
+               "\"decoded\": %zu, \"combined\": %zu, \"wrong\": %zu},\n",
+          combined->presses, combined->alone, combined->decoded,
+          combined->combined, combined->wrong);
+
+  fprintf(out, "  \"timing\": {\"scale\": %.2f, \"presses\": %zu, "
+               "\"alone\": %zu, \"decoded\": %zu, \"hw_sync\": %u},\n",
+          FAST_REMOTE_SCALE, learned->presses, learned->alone,
+          learned->decoded, learned->hw_sync);
+
+  fprintf(out, "  \"results\": {\n");
+  bool first = true;
+  for(size_t kind = 0; kind < BENCH_KIND_COUNT; kind++) {
+    if(result[kind].count == 0) {
+      continue;
+    }
+    fprintf(out, "%s    \"%s\": {\"captures\": %zu",
+            first ? "" : ",\n", bench_kind_name(kind), result[kind].count);
+    for(size_t i = 0; i < REPORTED_STATUS_COUNT; i++) {
+      rts_decode_status_t status = reported_status[i];
+      fprintf(out, ", \"%s\": %zu",
+              status_name(status), result[kind].status[status]);
+    }
+    fprintf(out, ", \"repaired\": %zu, \"wrong\": %zu}",
+            result[kind].repaired, result[kind].wrong);
+    first = false;
+  }
+  fprintf(out, "\n  }\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+  size_t count = 500;
+  uint32_t seed = 1;
+  double min_seconds = 0.5;
+  const char* report = "-";
+  bench_corpus_t corpus = { 0 };
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = strtoul(argv[++i], NULL, 0);
+    } else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      min_seconds = strtod(argv[++i], NULL);
+    } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      report = argv[++i];
+    } else if(!bench_corpus_add_file(&corpus, argv[i])) {
+      fprintf(stderr, "Cannot read captures from %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if(!bench_corpus_add_synthetic(&corpus, count, seed)
+     || corpus.count == 0) {
+    fprintf(stderr, "No captures to replay\n");
+    return 1;
+  }
+
+  FILE* out = strcmp(report, "-") == 0 ? stdout : fopen(report, "w");
+  if(out == NULL) {
+    fprintf(stderr, "Cannot write %s\n", report);
+    return 1;
+  }
+
+  kind_result_t result[BENCH_KIND_COUNT];
+  double share[RTS_STAGE_COUNT];
+  stream_result_t streamed;
+  classify(&corpus, result);
+  stream(&corpus, &streamed);
+  timing_t decode = time_decoder(&corpus, min_seconds);
+  profile_stages(&corpus, min_seconds, share);
+
+  // Pair the remotes of every other capture, as many as fit. Frames from the
+  // rest are turned away like those of neighbouring remotes.
+  remote_table_init();
+  for(size_t i = 0; i < corpus.count; i += 2) {
+    const uint8_t* frame = corpus.captures[i].frame;
+    if(corpus.captures[i].has_frame) {
+      remote_table_add((uint32_t)frame[6] << 16 | frame[5] << 8 | frame[4],
+                       (uint16_t)(frame[2] << 8 | frame[3]) - 1);
+    }
+  }
+
+  // The application logs every frame. Keep that out of the report, but still
+  // pay for formatting it.
+  FILE* app_log = fopen("/dev/null", "w");
+  FILE* saved_stdout = stdout;
+  if(app_log != NULL) {
+    stdout = app_log;
+  }
+  timing_t app = time_app(&corpus, min_seconds);
+  repeat_result_t repeated;
+  time_repeats(&corpus, min_seconds, &repeated);
+
+  bench_corpus_t marginal = { 0 };
+  combine_result_t combined;
+  if(!bench_corpus_add_marginal(&marginal, MARGINAL_PRESSES,
+                                MARGINAL_COPIES, seed)) {
+    fprintf(stderr, "No memory for the marginal presses\n");
+    return 1;
+  }
+  combine(&marginal, &combined);
+  bench_corpus_free(&marginal);
+
+  learn_result_t learned;
+  if(!learn(seed, &learned)) {
+    fprintf(stderr, "No memory for the presses of the fast remote\n");
+    return 1;
+  }
+
+  stream_app(&corpus, &streamed);
+  stdout = saved_stdout;
+  if(app_log != NULL) {
+    fclose(app_log);
+  }
+
+  write_report(out, &corpus, seed, &decode, &app, share, result, &streamed,
+               &repeated, &combined, &learned);
+  if(out != stdout) {
+    fclose(out);
+  }
+
+  fprintf(stderr, "%zu captures, %.1f ns/frame (%.0f frames/s) decode, "
+                  "%.1f ns/frame with parsePacket(), %.1f ns/frame for "
+                  "repeats\n",
+          corpus.count, decode.ns_per_frame, 1e9 / decode.ns_per_frame,
+          app.ns_per_frame, repeated.timing.ns_per_frame);
+
+  bench_corpus_free(&corpus);
+
+  const kind_result_t* extended = &result[BENCH_KIND_EXTENDED_56];
+  size_t cut = extended->count - extended->status[RTS_DECODE_OK]
+               + extended->wrong;
+  if(cut != 0) {
+    fprintf(stderr, "%zu of %zu extended frames which pass the checksum "
+                    "after 56 bits did not decode to 80 bits\n",
+            cut, extended->count);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,29 @@
+/***************************************************************************//**
+ * @file log_ring_standin.c
+ * @brief Host stand-in for the LDMA log buffer used by app_process.c
+ *******************************************************************************
+ * On the host, output goes straight to stdout, so there is never anything
+ * buffered or dropped.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "log_ring.h"
+
+void log_ring_init(void)
+{
+}
+
+bool log_ring_write(const void* data, size_t length)
+{
+  return fwrite(data, 1, length, stdout) == length;
+}
+
+void log_ring_process(void)
+{
+}
+
+void log_ring_get_stats(log_ring_stats_t* stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
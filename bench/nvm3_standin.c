@@ -0,0 +1,71 @@
+/***************************************************************************//**
+ * @file nvm3_standin.c
+ * @brief Host stand-in for NVM3, keeping objects in RAM
+ ******************************************************************************/
+#include <string.h>
+
+#include "nvm3_default.h"
+
+#define OBJECT_COUNT 128
+#define OBJECT_SIZE  64
+
+typedef struct {
+  nvm3_ObjectKey_t key;
+  size_t length;
+  uint8_t data[OBJECT_SIZE];
+} object_t;
+
+static object_t objects[OBJECT_COUNT];
+static size_t object_count = 0;
+
+nvm3_Handle_t* nvm3_defaultHandle = NULL;
+
+static object_t* find(nvm3_ObjectKey_t key)
+{
+  for(size_t i = 0; i < object_count; i++) {
+    if(objects[i].key == key) {
+      return &objects[i];
+    }
+  }
+  return NULL;
+}
+
+Ecode_t nvm3_readData(nvm3_Handle_t* h, nvm3_ObjectKey_t key,
+                      void* value, size_t len)
+{
+  (void) h;
+  object_t* object = find(key);
+  if(object == NULL || object->length != len) {
+    return ECODE_NVM3_ERR_KEY_NOT_FOUND;
+  }
+  memcpy(value, object->data, len);
+  return ECODE_NVM3_OK;
+}
+
+Ecode_t nvm3_writeData(nvm3_Handle_t* h, nvm3_ObjectKey_t key,
+                       const void* value, size_t len)
+{
+  (void) h;
+  object_t* object = find(key);
+  if(object == NULL) {
+    if(object_count == OBJECT_COUNT || len > OBJECT_SIZE) {
+      return ECODE_NVM3_ERR_STORAGE_FULL;
+    }
+    object = &objects[object_count++];
+    object->key = key;
+  }
+  object->length = len;
+  memcpy(object->data, value, len);
+  return ECODE_NVM3_OK;
+}
+
+Ecode_t nvm3_deleteObject(nvm3_Handle_t* h, nvm3_ObjectKey_t key)
+{
+  (void) h;
+  object_t* object = find(key);
+  if(object == NULL) {
+    return ECODE_NVM3_ERR_KEY_NOT_FOUND;
+  }
+  *object = objects[--object_count];
+  return ECODE_NVM3_OK;
+}
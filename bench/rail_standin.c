@@ -0,0 +1,195 @@
+/***************************************************************************//**
+ * @file rail_standin.c
+ * @brief Host stand-in for the RAIL functions referenced by app_process.c
+ *******************************************************************************
+ * Models the RX FIFO as far as the application can see it: packets take up
+ * FIFO space while they are received and held, and RAIL frees a packet which
+ * is not held once its RAIL_EVENT_RX_PACKET_RECEIVED has been handled. Like
+ * the real one, the FIFO threshold is a fill level, and
+ * RAIL_EVENT_RX_FIFO_ALMOST_FULL fires when the fill rises to it.
+ *
+ * Every packet comes in at the same RSSI.
+ *
+ * rail_standin_receive() plays a capture into the FIFO a chunk at a time and
+ * raises the events the radio would. Packets never wrap around the end of
+ * the FIFO here.
+ ******************************************************************************/
+#include "rail.h"
+
+// Packets the FIFO holds at once, at most
+#define PACKET_SLOTS 8
+// RSSI of every packet, in dBm
+#define RAIL_STANDIN_RSSI (-70)
+
+typedef struct {
+  const uint8_t* data;
+  uint16_t bytes;           ///< Bytes received so far
+  bool used;
+  bool complete;
+  bool held;
+} packet_slot_t;
+
+static packet_slot_t slots[PACKET_SLOTS];
+// Slot of the packet being received or received last, NULL if none
+static packet_slot_t* newest;
+static uint16_t threshold = UINT16_MAX;
+
+// In app_process.c
+void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events);
+
+static uint16_t fill(void)
+{
+  uint16_t bytes = 0;
+
+  for(size_t i = 0; i < PACKET_SLOTS; i++) {
+    if(slots[i].used) {
+      bytes += slots[i].bytes;
+    }
+  }
+  return bytes;
+}
+
+static packet_slot_t* find_slot(RAIL_RxPacketHandle_t packetHandle)
+{
+  if(packetHandle == RAIL_RX_PACKET_HANDLE_NEWEST) {
+    return newest;
+  }
+  for(size_t i = 0; i < PACKET_SLOTS; i++) {
+    if(packetHandle == &slots[i] && slots[i].used) {
+      return &slots[i];
+    }
+  }
+  return NULL;
+}
+
+bool rail_standin_receive(RAIL_Handle_t railHandle,
+                          const uint8_t* data,
+                          uint16_t length,
+                          uint16_t chunk)
+{
+  packet_slot_t* slot = NULL;
+  for(size_t i = 0; i < PACKET_SLOTS && slot == NULL; i++) {
+    if(!slots[i].used) {
+      slot = &slots[i];
+    }
+  }
+  if(slot == NULL) {
+    sl_rail_util_on_event(railHandle, RAIL_EVENT_RX_FIFO_OVERFLOW);
+    return false;
+  }
+
+  *slot = (packet_slot_t){ .data = data, .used = true };
+  newest = slot;
+
+  while(slot->bytes < length) {
+    uint16_t before = fill();
+    slot->bytes += length - slot->bytes < chunk ? length - slot->bytes : chunk;
+    if(before < threshold && fill() >= threshold) {
+      sl_rail_util_on_event(railHandle, RAIL_EVENT_RX_FIFO_ALMOST_FULL);
+    }
+  }
+
+  slot->complete = true;
+  sl_rail_util_on_event(railHandle, RAIL_EVENT_RX_PACKET_RECEIVED);
+  bool held = slot->held;
+  if(!held) {
+    slot->used = false;
+  }
+  newest = NULL;
+  return held;
+}
+
+RAIL_RxPacketHandle_t RAIL_GetRxPacketInfo(RAIL_Handle_t railHandle,
+                                           RAIL_RxPacketHandle_t packetHandle,
+                                           RAIL_RxPacketInfo_t *pPacketInfo)
+{
+  (void) railHandle;
+  packet_slot_t* slot = find_slot(packetHandle);
+
+  memset(pPacketInfo, 0, sizeof(*pPacketInfo));
+  if(slot == NULL) {
+    return RAIL_RX_PACKET_HANDLE_INVALID;
+  }
+
+  pPacketInfo->packetStatus = slot->complete ? RAIL_RX_PACKET_READY_SUCCESS
+                                             : RAIL_RX_PACKET_RECEIVING;
+  pPacketInfo->packetBytes = slot->bytes;
+  pPacketInfo->firstPortionBytes = slot->bytes;
+  pPacketInfo->firstPortionData = (uint8_t*) slot->data;
+  pPacketInfo->lastPortionData = NULL;
+  return slot;
+}
+
+void RAIL_CopyRxPacket(uint8_t *pDest,
+                       const RAIL_RxPacketInfo_t *pPacketInfo)
+{
+  memcpy(pDest, pPacketInfo->firstPortionData, pPacketInfo->packetBytes);
+}
+
+RAIL_Status_t RAIL_ReleaseRxPacket(RAIL_Handle_t railHandle,
+                                   RAIL_RxPacketHandle_t packetHandle)
+{
+  (void) railHandle;
+  packet_slot_t* slot = find_slot(packetHandle);
+
+  if(slot == NULL || !slot->held) {
+    return RAIL_STATUS_INVALID_PARAMETER;
+  }
+  slot->used = false;
+  slot->held = false;
+  return RAIL_STATUS_NO_ERROR;
+}
+
+RAIL_RxPacketHandle_t RAIL_HoldRxPacket(RAIL_Handle_t railHandle)
+{
+  (void) railHandle;
+
+  if(newest == NULL) {
+    return RAIL_RX_PACKET_HANDLE_INVALID;
+  }
+  newest->held = true;
+  return newest;
+}
+
+RAIL_Time_t RAIL_GetTime(void)
+{
+  return 0;
+}
+
+RAIL_Status_t RAIL_GetRxPacketDetailsAlt(RAIL_Handle_t railHandle,
+                                         RAIL_RxPacketHandle_t packetHandle,
+                                         RAIL_RxPacketDetails_t *pPacketDetails)
+{
+  (void) railHandle;
+  packet_slot_t* slot = find_slot(packetHandle);
+
+  memset(pPacketDetails, 0, sizeof(*pPacketDetails));
+  if(slot == NULL || !slot->complete) {
+    return RAIL_STATUS_INVALID_STATE;
+  }
+  pPacketDetails->crcPassed = true;
+  pPacketDetails->rssi = RAIL_STANDIN_RSSI;
+  return RAIL_STATUS_NO_ERROR;
+}
+
+uint16_t RAIL_SetRxFifoThreshold(RAIL_Handle_t railHandle,
+                                 uint16_t rxThreshold)
+{
+  (void) railHandle;
+  threshold = rxThreshold;
+  return rxThreshold;
+}
+
+uint16_t RAIL_GetRxFifoBytesAvailable(RAIL_Handle_t railHandle)
+{
+  (void) railHandle;
+  return fill();
+}
+
+// A packet being received comes in at a fixed level, in quarter dBm
+int16_t RAIL_GetRssi(RAIL_Handle_t railHandle, bool wait)
+{
+  (void) railHandle;
+  (void) wait;
+  return newest != NULL ? RAIL_STANDIN_RSSI * 4 : RAIL_RSSI_INVALID;
+}
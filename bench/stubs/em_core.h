@@ -0,0 +1,13 @@
+/***************************************************************************//**
+ * @file em_core.h
+ * @brief Host stand-in for the emlib critical sections
+ ******************************************************************************/
+#ifndef BENCH_EM_CORE_H
+#define BENCH_EM_CORE_H
+
+// The bench is single threaded, there is no interrupt to keep out
+#define CORE_DECLARE_IRQ_STATE
+#define CORE_ENTER_ATOMIC()
+#define CORE_EXIT_ATOMIC()
+
+#endif // BENCH_EM_CORE_H
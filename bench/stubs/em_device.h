@@ -0,0 +1,27 @@
+/***************************************************************************//**
+ * @file em_device.h
+ * @brief Host stand-in for the CMSIS intrinsics used by the decoder
+ ******************************************************************************/
+#ifndef BENCH_EM_DEVICE_H
+#define BENCH_EM_DEVICE_H
+
+#include <stdint.h>
+
+#define __STATIC_FORCEINLINE __attribute__((always_inline)) static inline
+
+static inline uint32_t __REV(uint32_t value)
+{
+  return __builtin_bswap32(value);
+}
+
+static inline uint8_t __CLZ(uint32_t value)
+{
+  return value == 0U ? 32U : (uint8_t) __builtin_clz(value);
+}
+
+static inline void __DMB(void)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif // BENCH_EM_DEVICE_H
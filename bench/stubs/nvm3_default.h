@@ -0,0 +1,27 @@
+/***************************************************************************//**
+ * @file nvm3_default.h
+ * @brief Host stand-in for the parts of NVM3 used by the application
+ ******************************************************************************/
+#ifndef BENCH_NVM3_DEFAULT_H
+#define BENCH_NVM3_DEFAULT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t Ecode_t;
+typedef uint32_t nvm3_ObjectKey_t;
+typedef struct nvm3_Handle nvm3_Handle_t;
+
+#define ECODE_NVM3_OK                  0U
+#define ECODE_NVM3_ERR_KEY_NOT_FOUND   0xE000A00DU
+#define ECODE_NVM3_ERR_STORAGE_FULL    0xE000A003U
+
+extern nvm3_Handle_t* nvm3_defaultHandle;
+
+Ecode_t nvm3_readData(nvm3_Handle_t* h, nvm3_ObjectKey_t key,
+                      void* value, size_t len);
+Ecode_t nvm3_writeData(nvm3_Handle_t* h, nvm3_ObjectKey_t key,
+                       const void* value, size_t len);
+Ecode_t nvm3_deleteObject(nvm3_Handle_t* h, nvm3_ObjectKey_t key);
+
+#endif // BENCH_NVM3_DEFAULT_H
@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file rail.h
+ * @brief Host stand-in for the parts of the RAIL API used by the application
+ ******************************************************************************/
+#ifndef BENCH_RAIL_H
+#define BENCH_RAIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef void* RAIL_Handle_t;
+typedef uint64_t RAIL_Events_t;
+typedef const void* RAIL_RxPacketHandle_t;
+typedef uint32_t RAIL_Time_t;
+typedef uint8_t RAIL_Status_t;
+
+#define RAIL_STATUS_NO_ERROR                  0U
+#define RAIL_STATUS_INVALID_PARAMETER         1U
+#define RAIL_STATUS_INVALID_STATE             2U
+
+#define RAIL_RX_PACKET_HANDLE_INVALID         ((RAIL_RxPacketHandle_t) NULL)
+#define RAIL_RX_PACKET_HANDLE_OLDEST          ((RAIL_RxPacketHandle_t) 1)
+#define RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE ((RAIL_RxPacketHandle_t) 2)
+#define RAIL_RX_PACKET_HANDLE_NEWEST          ((RAIL_RxPacketHandle_t) 3)
+
+#define RAIL_EVENT_RX_FIFO_ALMOST_FULL        (1ULL << 3)
+#define RAIL_EVENT_RX_PACKET_RECEIVED         (1ULL << 4)
+#define RAIL_EVENT_RX_FIFO_OVERFLOW           (1ULL << 6)
+#define RAIL_EVENT_RX_PACKET_ABORTED          (1ULL << 8)
+#define RAIL_EVENT_RX_FRAME_ERROR             (1ULL << 9)
+#define RAIL_EVENT_RX_SYNC1_DETECT            (1ULL << 12)
+
+typedef enum {
+  RAIL_RX_PACKET_NONE = 0,
+  RAIL_RX_PACKET_ABORT_FORMAT,
+  RAIL_RX_PACKET_ABORT_FILTERED,
+  RAIL_RX_PACKET_ABORT_ABORTED,
+  RAIL_RX_PACKET_ABORT_OVERFLOW,
+  RAIL_RX_PACKET_ABORT_CRC_ERROR,
+  RAIL_RX_PACKET_READY_CRC_ERROR,
+  RAIL_RX_PACKET_READY_SUCCESS,
+  RAIL_RX_PACKET_RECEIVING,
+} RAIL_RxPacketStatus_t;
+
+typedef struct {
+  RAIL_RxPacketStatus_t packetStatus;
+  uint16_t packetBytes;
+  uint16_t firstPortionBytes;
+  uint8_t *firstPortionData;
+  uint8_t *lastPortionData;
+} RAIL_RxPacketInfo_t;
+
+typedef struct {
+  RAIL_Time_t packetTime;
+} RAIL_PacketTimeStamp_t;
+
+typedef struct {
+  RAIL_PacketTimeStamp_t timeReceived;
+  bool crcPassed;
+  int8_t rssi;
+  uint8_t lqi;
+} RAIL_RxPacketDetails_t;
+
+#define RAIL_RSSI_INVALID_DBM                 (-128)
+#define RAIL_RSSI_INVALID                     ((int16_t)(-128 * 4))
+
+RAIL_Time_t RAIL_GetTime(void);
+RAIL_Status_t RAIL_GetRxPacketDetailsAlt(RAIL_Handle_t railHandle,
+                                         RAIL_RxPacketHandle_t packetHandle,
+                                         RAIL_RxPacketDetails_t *pPacketDetails);
+RAIL_RxPacketHandle_t RAIL_GetRxPacketInfo(RAIL_Handle_t railHandle,
+                                           RAIL_RxPacketHandle_t packetHandle,
+                                           RAIL_RxPacketInfo_t *pPacketInfo);
+void RAIL_CopyRxPacket(uint8_t *pDest,
+                       const RAIL_RxPacketInfo_t *pPacketInfo);
+RAIL_Status_t RAIL_ReleaseRxPacket(RAIL_Handle_t railHandle,
+                                   RAIL_RxPacketHandle_t packetHandle);
+RAIL_RxPacketHandle_t RAIL_HoldRxPacket(RAIL_Handle_t railHandle);
+uint16_t RAIL_SetRxFifoThreshold(RAIL_Handle_t railHandle,
+                                 uint16_t rxThreshold);
+uint16_t RAIL_GetRxFifoBytesAvailable(RAIL_Handle_t railHandle);
+int16_t RAIL_GetRssi(RAIL_Handle_t railHandle, bool wait);
+
+// Bench only, see rail_standin.c. Receives 'length' bytes of 'data' as one
+// packet, 'chunk' bytes at a time, and raises the RAIL events the radio would.
+// Returns true if the application held the packet.
+bool rail_standin_receive(RAIL_Handle_t railHandle,
+                          const uint8_t* data,
+                          uint16_t length,
+                          uint16_t chunk);
+
+#endif // BENCH_RAIL_H
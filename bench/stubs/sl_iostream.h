@@ -0,0 +1 @@
+/* Host stand-in: stdio is used directly */
@@ -0,0 +1,25 @@
+/***************************************************************************//**
+ * @file sl_simple_button_instances.h
+ * @brief Host stand-in for the button driver, the buttons are never pressed
+ ******************************************************************************/
+#ifndef BENCH_SL_SIMPLE_BUTTON_INSTANCES_H
+#define BENCH_SL_SIMPLE_BUTTON_INSTANCES_H
+
+#include <stdint.h>
+
+typedef struct {
+  uint8_t instance;
+} sl_button_t;
+
+#define SL_SIMPLE_BUTTON_PRESSED  1U
+#define SL_SIMPLE_BUTTON_RELEASED 0U
+
+static const sl_button_t sl_button_btn0 = { 0 };
+
+static inline uint8_t sl_button_get_state(const sl_button_t* handle)
+{
+  (void) handle;
+  return SL_SIMPLE_BUTTON_RELEASED;
+}
+
+#endif // BENCH_SL_SIMPLE_BUTTON_INSTANCES_H
@@ -0,0 +1,205 @@
+/***************************************************************************//**
+ * @file bridge_event.c
+ * @brief Binary events reported to the host over VCOM
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "bridge_event.h"
+#include "log_ring.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define CRC_INIT 0xFFFFU
+#define CRC_POLY 0x1021U
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool send(const uint8_t* payload, size_t length);
+static uint16_t crc16(const uint8_t* data, size_t length);
+static uint8_t* put_le(uint8_t* out, uint32_t value, size_t bytes);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Report a decoded frame
+ *****************************************************************************/
+bool bridge_event_send_frame(const bridge_event_frame_t* frame)
+{
+  uint8_t payload[12];
+  uint8_t* p = payload;
+
+  *p++ = BRIDGE_EVENT_FRAME;
+  p = put_le(p, frame->address, 3);
+  p = put_le(p, frame->rolling_code, 2);
+  *p++ = (uint8_t)((frame->flags << 4) | (frame->button & 0x0F));
+  *p++ = (uint8_t)frame->rssi;
+  p = put_le(p, frame->timestamp, 4);
+
+  return send(payload, (size_t)(p - payload));
+}
+
+/******************************************************************************
+ * Report a capture which did not decode
+ *****************************************************************************/
+bool bridge_event_send_decode_error(uint8_t status,
+                                    uint8_t flags,
+                                    int8_t rssi,
+                                    uint32_t timestamp)
+{
+  uint8_t payload[8];
+  uint8_t* p = payload;
+
+  *p++ = BRIDGE_EVENT_DECODE_ERROR;
+  *p++ = status;
+  *p++ = flags;
+  *p++ = (uint8_t)rssi;
+  p = put_le(p, timestamp, 4);
+
+  return send(payload, (size_t)(p - payload));
+}
+
+/******************************************************************************
+ * Report a remote being paired or unpaired
+ *****************************************************************************/
+bool bridge_event_send_pairing(uint32_t address, bool paired)
+{
+  uint8_t payload[5];
+  uint8_t* p = payload;
+
+  *p++ = BRIDGE_EVENT_PAIRING;
+  p = put_le(p, address, 3);
+  *p++ = paired ? 1 : 0;
+
+  return send(payload, (size_t)(p - payload));
+}
+
+/******************************************************************************
+ * Report the release of a button
+ *****************************************************************************/
+bool bridge_event_send_release(uint32_t address,
+                               uint8_t button,
+                               uint16_t repeats,
+                               uint32_t held_us)
+{
+  uint8_t payload[11];
+  uint8_t* p = payload;
+
+  *p++ = BRIDGE_EVENT_RELEASE;
+  p = put_le(p, address, 3);
+  *p++ = button;
+  p = put_le(p, repeats, 2);
+  p = put_le(p, held_us, 4);
+
+  return send(payload, (size_t)(p - payload));
+}
+
+/******************************************************************************
+ * Report the running drop counters and the paired remotes
+ *****************************************************************************/
+bool bridge_event_send_drops(uint32_t rx_dropped,
+                             uint32_t rx_lost,
+                             uint32_t log_dropped,
+                             uint32_t actuator_dropped,
+                             uint8_t paired)
+{
+  uint8_t payload[18];
+  uint8_t* p = payload;
+
+  *p++ = BRIDGE_EVENT_DROPS;
+  p = put_le(p, rx_dropped, 4);
+  p = put_le(p, rx_lost, 4);
+  p = put_le(p, log_dropped, 4);
+  p = put_le(p, actuator_dropped, 4);
+  *p++ = paired;
+
+  return send(payload, (size_t)(p - payload));
+}
+
+/******************************************************************************
+ * Frame an event payload for the wire
+ *****************************************************************************/
+size_t bridge_event_encode(const uint8_t* payload,
+                           size_t length,
+                           uint8_t* encoded)
+{
+  uint8_t crc[2];
+  put_le(crc, crc16(payload, length), 2);
+
+  // COBS: every zero is replaced by the distance to the next one, starting
+  // with a code byte in front. Frames are short enough to never need the
+  // 254-byte block split.
+  size_t code_at = 0;
+  size_t out = 1;
+  for(size_t i = 0; i < length + 2; i++) {
+    uint8_t byte = i < length ? payload[i] : crc[i - length];
+    if(byte == 0) {
+      encoded[code_at] = (uint8_t)(out - code_at);
+      code_at = out++;
+    } else {
+      encoded[out++] = byte;
+    }
+  }
+  encoded[code_at] = (uint8_t)(out - code_at);
+  encoded[out++] = 0;
+
+  return out;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static bool send(const uint8_t* payload, size_t length)
+{
+  uint8_t encoded[BRIDGE_EVENT_ENCODED_MAX];
+  return log_ring_write(encoded, bridge_event_encode(payload, length, encoded));
+}
+
+// CRC-16/CCITT-FALSE, a bit at a time. Events are a dozen bytes, so a table
+// is not worth the flash.
+static uint16_t crc16(const uint8_t* data, size_t length)
+{
+  uint16_t crc = CRC_INIT;
+
+  for(size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)(data[i] << 8);
+    for(int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ CRC_POLY)
+                            : (uint16_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+static uint8_t* put_le(uint8_t* out, uint32_t value, size_t bytes)
+{
+  for(size_t i = 0; i < bytes; i++) {
+    *out++ = (uint8_t)(value >> (8 * i));
+  }
+  return out;
+}
@@ -0,0 +1,177 @@
+/***************************************************************************//**
+ * @file bridge_event.h
+ * @brief Binary events reported to the host over VCOM
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef BRIDGE_EVENT_H
+#define BRIDGE_EVENT_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Each event goes out as one frame: the payload below followed by its
+/// CRC-16/CCITT-FALSE (little endian), COBS encoded and terminated by a zero
+/// byte. All multi-byte fields are little endian. host/rts_events.py decodes
+/// the stream.
+///
+/// Payload of BRIDGE_EVENT_FRAME, 12 bytes:
+///   0     event type
+///   1-3   remote address
+///   4-5   rolling code
+///   6     button (low nibble), BRIDGE_EVENT_FLAG_* (high nibble)
+///   7     RSSI in dBm, -128 if unknown
+///   8-11  RAIL timestamp in us
+///
+/// Payload of BRIDGE_EVENT_DECODE_ERROR, 8 bytes:
+///   0     event type
+///   1     rts_decode_status_t
+///   2     BRIDGE_EVENT_FLAG_*
+///   3     RSSI in dBm, -128 if unknown
+///   4-7   RAIL timestamp in us
+///
+/// Payload of BRIDGE_EVENT_PAIRING, 5 bytes:
+///   0     event type
+///   1-3   remote address
+///   4     1 if the remote was paired, 0 if it was unpaired
+///
+/// Payload of BRIDGE_EVENT_DROPS, 18 bytes, running totals since reset and
+/// the current number of paired remotes:
+///   0     event type
+///   1-4   packets dropped because the RX queue was full
+///   5-8   held packets RAIL no longer knew about
+///   9-12  log bytes dropped because the log buffer was full
+///   13-16 io remote commands dropped because the actuator queue was full
+///   17    paired remotes
+///
+/// Payload of BRIDGE_EVENT_RELEASE, 11 bytes, once a reported press ends:
+///   0     event type
+///   1-3   remote address
+///   4     button
+///   5-6   repeat frames received after the first one
+///   7-10  time from the first to the last frame in us
+#define BRIDGE_EVENT_FRAME        0x01
+#define BRIDGE_EVENT_DECODE_ERROR 0x02
+#define BRIDGE_EVENT_DROPS        0x03
+#define BRIDGE_EVENT_PAIRING      0x04
+#define BRIDGE_EVENT_RELEASE      0x05
+
+/// Frame came after the longer sync of a repeated frame
+#define BRIDGE_EVENT_FLAG_REPEATED 0x01
+/// Frame was decoded while the capture was still coming in
+#define BRIDGE_EVENT_FLAG_EARLY    0x02
+/// Frame was voted together from frames which failed to decode on their own
+#define BRIDGE_EVENT_FLAG_COMBINED 0x04
+/// Frame only passed its checksum after a doubtful pulse was read differently
+#define BRIDGE_EVENT_FLAG_REPAIRED 0x08
+
+/// Longest payload of any event
+#define BRIDGE_EVENT_PAYLOAD_MAX 18
+/// Longest encoded event: payload, CRC, COBS overhead and delimiter
+#define BRIDGE_EVENT_ENCODED_MAX (BRIDGE_EVENT_PAYLOAD_MAX + 2 + 1 + 1)
+
+/// A decoded frame, as reported to the host
+typedef struct {
+  uint32_t address;               ///< Remote address, 24 bits
+  uint16_t rolling_code;          ///< Rolling code
+  uint8_t button;                 ///< Button nibble
+  uint8_t flags;                  ///< BRIDGE_EVENT_FLAG_*
+  int8_t rssi;                    ///< RSSI in dBm
+  uint32_t timestamp;             ///< RAIL timestamp in us
+} bridge_event_frame_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Report a decoded frame.
+ *
+ * @param frame Frame to report
+ * @returns true if sent, false if there was no room in the log buffer
+ *****************************************************************************/
+bool bridge_event_send_frame(const bridge_event_frame_t* frame);
+
+/**************************************************************************//**
+ * Report a capture which did not decode.
+ *
+ * @param status Decode verdict
+ * @param flags BRIDGE_EVENT_FLAG_*
+ * @param rssi RSSI in dBm
+ * @param timestamp RAIL timestamp in us
+ * @returns true if sent, false if there was no room in the log buffer
+ *****************************************************************************/
+bool bridge_event_send_decode_error(uint8_t status,
+                                    uint8_t flags,
+                                    int8_t rssi,
+                                    uint32_t timestamp);
+
+/**************************************************************************//**
+ * Report a remote being paired or unpaired in learning mode.
+ *
+ * @param address Remote address
+ * @param paired true if the remote was paired, false if it was unpaired
+ * @returns true if sent, false if there was no room in the log buffer
+ *****************************************************************************/
+bool bridge_event_send_pairing(uint32_t address, bool paired);
+
+/**************************************************************************//**
+ * Report that the button of a reported frame was released.
+ *
+ * @param address Remote address
+ * @param button Button nibble
+ * @param repeats Repeat frames received after the first one
+ * @param held_us Time from the first to the last frame in us
+ * @returns true if sent, false if there was no room in the log buffer
+ *****************************************************************************/
+bool bridge_event_send_release(uint32_t address,
+                               uint8_t button,
+                               uint16_t repeats,
+                               uint32_t held_us);
+
+/**************************************************************************//**
+ * Report the running drop counters and the number of paired remotes.
+ *
+ * @param rx_dropped Packets dropped because the RX queue was full
+ * @param rx_lost Held packets RAIL no longer knew about
+ * @param log_dropped Log bytes dropped because the log buffer was full
+ * @param actuator_dropped io remote commands dropped because the actuator
+ *                         queue was full
+ * @param paired Paired remotes
+ * @returns true if sent, false if there was no room in the log buffer
+ *****************************************************************************/
+bool bridge_event_send_drops(uint32_t rx_dropped,
+                             uint32_t rx_lost,
+                             uint32_t log_dropped,
+                             uint32_t actuator_dropped,
+                             uint8_t paired);
+
+/**************************************************************************//**
+ * Frame an event payload for the wire.
+ *
+ * @param payload Event payload
+ * @param length Payload length, at most BRIDGE_EVENT_PAYLOAD_MAX
+ * @param encoded Receives the frame, BRIDGE_EVENT_ENCODED_MAX bytes
+ * @returns Length of the frame, including the delimiter
+ *****************************************************************************/
+size_t bridge_event_encode(const uint8_t* payload,
+                           size_t length,
+                           uint8_t* encoded);
+
+#endif  // BRIDGE_EVENT_H
@@ -0,0 +1,85 @@
+/***************************************************************************//**
+ * @file
+ * @brief Actuator (io remote button outputs) User Config
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc.  Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement.  This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef ACTUATOR_CONFIG_H
+#define ACTUATOR_CONFIG_H
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o ACTUATOR_HOLD_TIME_MS> Button hold time [ms] <1-1700>
+// <i> How long an io remote button is held down per press
+// <i> Default: 250
+#define ACTUATOR_HOLD_TIME_MS          250
+
+// <q ACTUATOR_ACTIVE_LOW> Buttons are active low
+// <i> Set if a pressed io remote button pulls its line to ground
+// <i> Default: 1
+#define ACTUATOR_ACTIVE_LOW            1
+
+// <o ACTUATOR_COALESCE_MS> Duplicate command window [ms] <0-10000>
+// <i> A command for the same buttons as the one before it, within this long,
+// <i> is merged into it rather than pressed again
+// <i> Default: 1000
+#define ACTUATOR_COALESCE_MS           1000
+
+// <o ACTUATOR_MIN_GAP_MS> Minimum gap between presses [ms] <0-10000>
+// <i> How long the io remote needs with all buttons released before it
+// <i> takes the next press
+// <i> Default: 250
+#define ACTUATOR_MIN_GAP_MS            250
+
+// <<< end of configuration section >>>
+
+// <<< sl:start pin_tool >>>
+// Each button is driven by CC0 of its own timer, so the locations below are
+// the CC0 locations of that timer for the pin. The clock and the counter
+// width in bits (16 for a TIMER, 32 for a WTIMER) after each timer have to
+// be changed together with it.
+
+// <timer signal=CC0> ACTUATOR_MY
+// $[TIMER_ACTUATOR_MY]
+#define ACTUATOR_MY_PERIPHERAL         TIMER0
+#define ACTUATOR_MY_PORT               gpioPortD
+#define ACTUATOR_MY_PIN                10
+#define ACTUATOR_MY_LOC                18
+// [TIMER_ACTUATOR_MY]$
+#define ACTUATOR_MY_CLOCK              cmuClock_TIMER0
+#define ACTUATOR_MY_WIDTH              16
+
+// <timer signal=CC0> ACTUATOR_UP
+// $[TIMER_ACTUATOR_UP]
+#define ACTUATOR_UP_PERIPHERAL         TIMER1
+#define ACTUATOR_UP_PORT               gpioPortD
+#define ACTUATOR_UP_PIN                11
+#define ACTUATOR_UP_LOC                19
+// [TIMER_ACTUATOR_UP]$
+#define ACTUATOR_UP_CLOCK              cmuClock_TIMER1
+#define ACTUATOR_UP_WIDTH              16
+
+// <timer signal=CC0> ACTUATOR_DOWN
+// $[TIMER_ACTUATOR_DOWN]
+#define ACTUATOR_DOWN_PERIPHERAL       WTIMER0
+#define ACTUATOR_DOWN_PORT             gpioPortD
+#define ACTUATOR_DOWN_PIN              12
+#define ACTUATOR_DOWN_LOC              20
+// [TIMER_ACTUATOR_DOWN]$
+#define ACTUATOR_DOWN_CLOCK            cmuClock_WTIMER0
+#define ACTUATOR_DOWN_WIDTH            32
+
+// <<< sl:end pin_tool >>>
+
+#endif // ACTUATOR_CONFIG_H
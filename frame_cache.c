@@ -0,0 +1,196 @@
+/***************************************************************************//**
+ * @file frame_cache.c
+ * @brief Recently decoded frames, so repeats are recognised early
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "frame_cache.h"
+#include "em_core.h"
+#include <stddef.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define LOOKUP_BYTES (RTS_LOOKUP_BITS / 8)
+
+typedef struct {
+  uint32_t first_seen;
+  uint32_t last_seen;
+  uint16_t repeats;
+  bool report;
+} entry_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static int find(const rts_frame_t* frame, size_t bytes);
+static void remove_entry(size_t index);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// Remembered frames are kept packed at the front. The RAIL ISR reads frames
+// and count, so the main loop only changes them inside atomic sections.
+static rts_frame_t frames[FRAME_CACHE_SIZE];
+static volatile size_t count;
+
+// Only touched from the main loop
+static entry_t entries[FRAME_CACHE_SIZE];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Complete a frame from a remembered one with the same first bits
+ *****************************************************************************/
+bool frame_cache_lookup(rts_frame_t* frame)
+{
+  int index = find(frame, LOOKUP_BYTES);
+  if(index < 0) {
+    return false;
+  }
+
+  memcpy(&frame->data[LOOKUP_BYTES],
+         &frames[index].data[LOOKUP_BYTES],
+         RTS_FRAME_BYTES - LOOKUP_BYTES);
+  return true;
+}
+
+/******************************************************************************
+ * Remember a decoded frame
+ *****************************************************************************/
+void frame_cache_add(const rts_frame_t* frame, uint32_t now, bool report)
+{
+  // A repeat can be decoded in full before the main loop got round to
+  // remembering the frame before it
+  if(frame_cache_hold(frame, now)) {
+    return;
+  }
+
+  size_t index = count;
+
+  if(index == FRAME_CACHE_SIZE) {
+    // Presses whose release is reported stay until they are released, so
+    // only frames which are not reported make room
+    index = SIZE_MAX;
+    for(size_t i = 0; i < FRAME_CACHE_SIZE; i++) {
+      if(!entries[i].report
+         && (index == SIZE_MAX
+             || now - entries[i].last_seen > now - entries[index].last_seen)) {
+        index = i;
+      }
+    }
+    if(index == SIZE_MAX) {
+      return;
+    }
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_ATOMIC();
+  memcpy(frames[index].data, frame->data, RTS_FRAME_BYTES);
+  if(index == count) {
+    count = index + 1;
+  }
+  CORE_EXIT_ATOMIC();
+
+  entries[index].first_seen = now;
+  entries[index].last_seen = now;
+  entries[index].repeats = 0;
+  entries[index].report = report;
+}
+
+/******************************************************************************
+ * Note a repeat of a remembered frame
+ *****************************************************************************/
+bool frame_cache_hold(const rts_frame_t* frame, uint32_t now)
+{
+  int index = find(frame, RTS_FRAME_BYTES);
+  if(index < 0) {
+    return false;
+  }
+
+  entries[index].last_seen = now;
+  if(entries[index].repeats < UINT16_MAX) {
+    entries[index].repeats++;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Forget frames whose button has been released
+ *****************************************************************************/
+bool frame_cache_expire(uint32_t now, frame_cache_release_t* release)
+{
+  size_t i = 0;
+
+  while(i < count) {
+    const entry_t* entry = &entries[i];
+    if(now - entry->last_seen < FRAME_CACHE_RELEASE_US) {
+      i++;
+      continue;
+    }
+
+    bool report = entry->report;
+    if(report) {
+      const uint8_t* data = frames[i].data;
+      release->address = (uint32_t)data[6] << 16 | data[5] << 8 | data[4];
+      release->button = data[1] >> 4;
+      release->repeats = entry->repeats;
+      release->held_us = entry->last_seen - entry->first_seen;
+    }
+
+    remove_entry(i);
+    if(report) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+// Index of the remembered frame starting with the same 'bytes', or -1
+static int find(const rts_frame_t* frame, size_t bytes)
+{
+  for(size_t i = 0; i < count; i++) {
+    if(memcmp(frames[i].data, frame->data, bytes) == 0) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+// Move the last frame into the gap, so the rest stay packed
+static void remove_entry(size_t index)
+{
+  size_t last = count - 1;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_ATOMIC();
+  frames[index] = frames[last];
+  count = last;
+  CORE_EXIT_ATOMIC();
+
+  entries[index] = entries[last];
+}
@@ -0,0 +1,109 @@
+/***************************************************************************//**
+ * @file frame_cache.h
+ * @brief Recently decoded frames, so repeats are recognised early
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rts_decoder.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of frames remembered. Each button held down on a remote within
+/// range takes one.
+#define FRAME_CACHE_SIZE 4
+
+/// A button counts as released once no repeat of its frame came in for this
+/// long. Repeats are sent about every 100 ms while a button is held.
+#define FRAME_CACHE_RELEASE_US 500000UL
+
+/// A press which has ended
+typedef struct {
+  uint32_t address;               ///< Remote address, 24 bits
+  uint8_t button;                 ///< Button nibble
+  uint16_t repeats;               ///< Repeats received after the first frame
+  uint32_t held_us;               ///< First to last frame, in us
+} frame_cache_release_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Frame lookup for the decoder, see rts_frame_lookup_t. Safe to call from
+ * the RAIL ISR.
+ *
+ * @param frame Frame with its first RTS_LOOKUP_BITS decoded
+ * @returns true if those bits match a remembered frame, which is then copied
+ *          into 'frame'
+ *
+ * Only the key, button, checksum and rolling code are compared, as the
+ * address is still on its way. Checking it would mean decoding the whole
+ * frame, which is what the lookup saves. The address in 'frame' is the one
+ * of the remembered frame, not necessarily the one sent.
+ *
+ * So a press of another remote is taken for a repeat of a remembered frame if
+ * it comes within FRAME_CACHE_RELEASE_US of that frame with the same button
+ * and rolling code, and with a checksum nibble which happens to match as
+ * well. It then only extends the remembered press: it is not checked against
+ * the remote table, not acted on and not reported. With 16-bit rolling codes
+ * and the checksum, that is about one in a million presses which overlap
+ * with one of another remote on the same button.
+ *****************************************************************************/
+bool frame_cache_lookup(rts_frame_t* frame);
+
+/**************************************************************************//**
+ * Remember a fully decoded frame, so that its repeats are recognised. Main
+ * loop only.
+ *
+ * @param frame Decoded frame
+ * @param now Current time in us, wrapping
+ * @param report true to have the release of the press reported by
+ *               frame_cache_expire()
+ *
+ * A frame which is already remembered counts as a repeat of it instead. If
+ * the cache is full, the frame not to be reported which was heard from
+ * longest ago is dropped to make room. A press whose release is to be
+ * reported is never dropped. If all remembered frames are such presses, the
+ * new frame is not remembered, so its repeats are decoded in full.
+ *****************************************************************************/
+void frame_cache_add(const rts_frame_t* frame, uint32_t now, bool report);
+
+/**************************************************************************//**
+ * Note a repeat of a remembered frame. Main loop only.
+ *
+ * @param frame Frame completed by frame_cache_lookup()
+ * @param now Current time in us, wrapping
+ * @returns true if the frame is still remembered
+ *****************************************************************************/
+bool frame_cache_hold(const rts_frame_t* frame, uint32_t now);
+
+/**************************************************************************//**
+ * Forget frames whose button has been released. Call from the main loop
+ * until it returns false.
+ *
+ * @param now Current time in us, wrapping
+ * @param release Receives a press which ended, if it is to be reported
+ * @returns true if 'release' was filled in
+ *****************************************************************************/
+bool frame_cache_expire(uint32_t now, frame_cache_release_t* release);
+
+#endif  // FRAME_CACHE_H
@@ -0,0 +1,331 @@
+/***************************************************************************//**
+ * @file frame_combiner.c
+ * @brief Majority vote over failed copies of a frame
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "frame_combiner.h"
+#include <stddef.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+// Copies voted on at once
+#define VOTERS 3
+
+#define SAMPLES (FRAME_COMBINER_BYTES * 8)
+
+// Samples are kept 32 to a word, the first one in the MSB as in a capture
+#define WORDS ((SAMPLES + 31) / 32)
+
+// Samples of the last word which belong to the frame
+#define LAST_WORD_MASK (0xFFFFFFFFUL << (WORDS * 32 - SAMPLES))
+
+#if FRAME_COMBINER_ALIGN >= 32
+#error "FRAME_COMBINER_ALIGN must be less than a word"
+#endif
+
+typedef struct {
+  // The samples, between a word of copies of the first sample and one of
+  // copies of the last, so that they can be read moved by less than a word.
+  // Past the last sample, the rest of the last word repeats it as well.
+  uint32_t words[WORDS + 2];
+  uint32_t received;
+  uint16_t hw_sync;       // Timing measured on the capture, 0 if none was
+} entry_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void expire(uint32_t now);
+static void keep(const rts_capture_t* capture,
+                 size_t start,
+                 uint16_t hw_sync,
+                 uint32_t now);
+static void compact(uint32_t kept_mask);
+static uint32_t word_at(const entry_t* entry, size_t word, int shift);
+static uint16_t distance(const entry_t* a, const entry_t* b, int8_t* offset);
+static bool vote(rts_decoder_t* decoder,
+                 const size_t voters[VOTERS],
+                 const int offsets[VOTERS]);
+static void drop(const size_t voters[VOTERS]);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// Kept failed frames, oldest first
+static entry_t entries[FRAME_COMBINER_SIZE];
+static size_t count;
+
+// Samples each pair of kept frames differs in, and the offset which lines up
+// the second one best with the first. Worked out once, as the later of the
+// two is kept.
+static uint16_t pair_distance[FRAME_COMBINER_SIZE][FRAME_COMBINER_SIZE];
+static int8_t pair_offset[FRAME_COMBINER_SIZE][FRAME_COMBINER_SIZE];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Keep failed frames and try to decode a vote of them
+ *****************************************************************************/
+bool frame_combiner_add(rts_decoder_t* decoder,
+                        const rts_capture_t* capture,
+                        uint32_t now)
+{
+  size_t added = 0;
+  uint16_t hw_sync = rts_decoder_hw_sync(decoder);
+
+  expire(now);
+  for(size_t i = 0; i < decoder->failed_count; i++) {
+    if(decoder->failed_start[i] < capture->length * 8) {
+      keep(capture, decoder->failed_start[i], hw_sync, now);
+      added++;
+    }
+  }
+
+  // Each new frame votes with the two copies of it closest to it
+  for(size_t i = count - added; i < count; i++) {
+    size_t voters[VOTERS] = { i, SIZE_MAX, SIZE_MAX };
+    size_t best[VOTERS] = { 0, SIZE_MAX, SIZE_MAX };
+    int offsets[VOTERS] = { 0, 0, 0 };
+
+    for(size_t j = 0; j < count; j++) {
+      size_t d = j == i ? SIZE_MAX : pair_distance[i][j];
+      if(d > FRAME_COMBINER_MAX_DISTANCE) {
+        continue;
+      }
+      if(d < best[1]) {
+        best[2] = best[1];
+        voters[2] = voters[1];
+        offsets[2] = offsets[1];
+        best[1] = d;
+        voters[1] = j;
+        offsets[1] = pair_offset[i][j];
+      } else if(d < best[2]) {
+        best[2] = d;
+        voters[2] = j;
+        offsets[2] = pair_offset[i][j];
+      }
+    }
+
+    if(voters[2] != SIZE_MAX && vote(decoder, voters, offsets)) {
+      drop(voters);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void expire(uint32_t now)
+{
+  uint32_t kept_mask = 0;
+
+  for(size_t i = 0; i < count; i++) {
+    if(now - entries[i].received < FRAME_COMBINER_WINDOW_US) {
+      kept_mask |= 1UL << i;
+    }
+  }
+  compact(kept_mask);
+}
+
+// Copy the samples of a failed frame out of the capture, starting at sample
+// 'start', and work out how far it is from each frame already kept. Past the
+// end of the capture, the last sample is repeated.
+static void keep(const rts_capture_t* capture,
+                 size_t start,
+                 uint16_t hw_sync,
+                 uint32_t now)
+{
+  if(count == FRAME_COMBINER_SIZE) {
+    // Make room by dropping the oldest
+    compact(((1UL << count) - 1) & ~1UL);
+  }
+
+  entry_t* entry = &entries[count];
+  size_t byte = start / 8;
+  unsigned int shift = start % 8;
+  uint8_t last = rts_capture_byte(capture, capture->length - 1) & 1
+                 ? 0xFF : 0x00;
+  uint8_t samples[WORDS * 4];
+
+  for(size_t i = 0; i < FRAME_COMBINER_BYTES; i++, byte++) {
+    uint8_t hi = byte < capture->length ? rts_capture_byte(capture, byte)
+                                        : last;
+    uint8_t lo = byte + 1 < capture->length
+                 ? rts_capture_byte(capture, byte + 1) : last;
+    samples[i] = (uint8_t)((hi << shift) | (lo >> (8 - shift)));
+  }
+
+  uint32_t first_sample = 0UL - (samples[0] >> 7);
+  uint32_t last_sample = 0UL - (samples[FRAME_COMBINER_BYTES - 1] & 1);
+  memset(&samples[FRAME_COMBINER_BYTES], (uint8_t) last_sample,
+         sizeof(samples) - FRAME_COMBINER_BYTES);
+  entry->words[0] = first_sample;
+  for(size_t w = 0; w < WORDS; w++) {
+    entry->words[w + 1] = (uint32_t) samples[4 * w] << 24
+                          | (uint32_t) samples[4 * w + 1] << 16
+                          | (uint32_t) samples[4 * w + 2] << 8
+                          | samples[4 * w + 3];
+  }
+  entry->words[WORDS + 1] = last_sample;
+  entry->received = now;
+  entry->hw_sync = hw_sync;
+
+  for(size_t j = 0; j < count; j++) {
+    pair_distance[count][j] = distance(entry, &entries[j],
+                                      &pair_offset[count][j]);
+    pair_distance[j][count] = pair_distance[count][j];
+    pair_offset[j][count] = (int8_t) -pair_offset[count][j];
+  }
+  count++;
+}
+
+// Keep only the frames set in 'kept_mask', in the same order, along with the
+// distances between them
+static void compact(uint32_t kept_mask)
+{
+  size_t kept = 0;
+
+  for(size_t i = 0; i < count; i++) {
+    if((kept_mask & (1UL << i)) == 0) {
+      continue;
+    }
+    size_t column = 0;
+    for(size_t j = 0; j < count; j++) {
+      if(kept_mask & (1UL << j)) {
+        pair_distance[kept][column] = pair_distance[i][j];
+        pair_offset[kept][column] = pair_offset[i][j];
+        column++;
+      }
+    }
+    entries[kept++] = entries[i];
+  }
+  count = kept;
+}
+
+// The 32 samples of a kept frame from sample 32 * 'word' + 'shift' on. Before
+// the first and past the last sample, those are repeated.
+static uint32_t word_at(const entry_t* entry, size_t word, int shift)
+{
+  const uint32_t* words = &entry->words[word + 1];
+
+  if(shift > 0) {
+    return (words[0] << shift) | (words[1] >> (32 - shift));
+  } else if(shift < 0) {
+    return (words[-1] << (32 + shift)) | (words[0] >> -shift);
+  }
+  return words[0];
+}
+
+// Number of samples two kept frames differ in, with 'b' moved by the offset
+// which lines it up best with 'a'. A glitch on a SW sync edge moves the start
+// of a frame by a sample or two.
+static uint16_t distance(const entry_t* a, const entry_t* b, int8_t* offset)
+{
+  uint16_t best = UINT16_MAX;
+
+  for(int shift = -FRAME_COMBINER_ALIGN; shift <= FRAME_COMBINER_ALIGN;
+      shift++) {
+    uint16_t differ = 0;
+    for(size_t w = 0; w < WORDS && differ < best; w++) {
+      uint32_t mask = w == WORDS - 1 ? LAST_WORD_MASK : 0xFFFFFFFFUL;
+      differ += (uint16_t) __builtin_popcount(
+        (a->words[w + 1] ^ word_at(b, w, shift)) & mask);
+    }
+    if(differ < best) {
+      best = differ;
+      *offset = (int8_t) shift;
+    }
+  }
+  return best;
+}
+
+// Decode the per-sample majority of three copies, each moved by its offset,
+// at the mean timing measured on them
+static bool vote(rts_decoder_t* decoder,
+                 const size_t voters[VOTERS],
+                 const int offsets[VOTERS])
+{
+  uint8_t samples[WORDS * 4];
+  uint32_t hw_sync = 0;
+  size_t timed = 0;
+
+  for(size_t w = 0; w < WORDS; w++) {
+    uint32_t a = word_at(&entries[voters[0]], w, offsets[0]);
+    uint32_t b = word_at(&entries[voters[1]], w, offsets[1]);
+    uint32_t c = word_at(&entries[voters[2]], w, offsets[2]);
+    uint32_t majority = (a & b) | (a & c) | (b & c);
+    samples[4 * w] = (uint8_t)(majority >> 24);
+    samples[4 * w + 1] = (uint8_t)(majority >> 16);
+    samples[4 * w + 2] = (uint8_t)(majority >> 8);
+    samples[4 * w + 3] = (uint8_t) majority;
+  }
+
+  for(size_t v = 0; v < VOTERS; v++) {
+    if(entries[voters[v]].hw_sync != 0) {
+      hw_sync += entries[voters[v]].hw_sync;
+      timed++;
+    }
+  }
+
+  rts_capture_t combined = {
+    .first = samples,
+    .first_length = FRAME_COMBINER_BYTES,
+    .last = NULL,
+    .length = FRAME_COMBINER_BYTES,
+  };
+
+  // The vote has no sync pulses left to measure, so without the timing of the
+  // copies it would be decoded at the nominal rate
+  rts_decoder_start_frame(decoder);
+  if(timed != 0) {
+    rts_decoder_set_timing(decoder, (uint16_t)(hw_sync / timed));
+  }
+  rts_decoder_feed(decoder, &combined);
+
+  // A vote which passes the checksum alone is still a fluke one time in 16
+  if(rts_decoder_finish(decoder) != RTS_DECODE_OK
+     || (decoder->frame.data[0] >> 4) != RTS_KEY_NIBBLE) {
+    decoder->status = RTS_DECODE_CHECKSUM;
+    return false;
+  }
+
+  decoder->frame.hw_sync = rts_decoder_hw_sync(decoder);
+  decoder->frame.repeated = true;
+  decoder->frame.combined = true;
+  return true;
+}
+
+static void drop(const size_t voters[VOTERS])
+{
+  uint32_t kept_mask = (1UL << count) - 1;
+
+  for(size_t v = 0; v < VOTERS; v++) {
+    kept_mask &= ~(1UL << voters[v]);
+  }
+  compact(kept_mask);
+}
@@ -0,0 +1,76 @@
+/***************************************************************************//**
+ * @file frame_combiner.h
+ * @brief Majority vote over failed copies of a frame
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef FRAME_COMBINER_H
+#define FRAME_COMBINER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rts_decoder.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of failed frames kept for combining
+#define FRAME_COMBINER_SIZE 6
+
+/// Samples kept per failed frame, from the end of its SW sync: the 448 of
+/// the frame bits, plus room for a remote running up to 10% slow
+#define FRAME_COMBINER_BYTES 62
+
+/// Failed frames are only combined with others received this recently. A
+/// press and its repeats take well under a second.
+#define FRAME_COMBINER_WINDOW_US 1000000UL
+
+/// Samples two failed frames may be moved against each other to line them
+/// up, half a Manchester half-bit either way
+#define FRAME_COMBINER_ALIGN 2
+
+/// Two failed frames are taken to be copies of the same frame if at most
+/// this many of their samples differ. Jitter moves a few samples at every
+/// edge, a different frame changes about a quarter of them.
+#define FRAME_COMBINER_MAX_DISTANCE 96
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Keep the frames of a capture which failed to decode, and try to decode a
+ * majority vote of them with failed copies kept from earlier captures.
+ * Main loop only.
+ *
+ * @param decoder Decoder the capture failed in. Decodes the vote, and holds
+ *                the frame afterwards.
+ * @param capture The capture, still in place
+ * @param now Current time in us, wrapping
+ * @returns true if the vote decoded
+ *
+ * Copies of a frame are lined up on the end of their SW sync and voted on
+ * sample by sample, three at a time. Glitches rarely hit the same samples in
+ * two copies, so they drop out of the vote. The vote is decoded at the mean
+ * timing measured on the copies, and only counts if it carries the key nibble
+ * as well as a valid checksum. The copies which went into a frame which
+ * decoded are dropped.
+ *****************************************************************************/
+bool frame_combiner_add(rts_decoder_t* decoder,
+                        const rts_capture_t* capture,
+                        uint32_t now);
+
+#endif  // FRAME_COMBINER_H
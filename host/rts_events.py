@@ -0,0 +1,227 @@
+"""Decoder for the binary events the RTS-to-IO bridge reports over VCOM.
+
+Each event is a COBS-encoded frame terminated by a zero byte. The decoded
+frame is the event payload followed by its CRC-16/CCITT-FALSE, little endian.
+The payload layouts are documented in bridge_event.h.
+
+Use EventDecoder to turn a byte stream into events, for instance:
+
+    decoder = EventDecoder()
+    with open("/dev/ttyACM0", "rb", buffering=0) as port:
+        while True:
+            for event in decoder.feed(port.read(64)):
+                print(event)
+
+or run this file on a port (set up with stty beforehand) or a capture file to
+print the events as JSON lines.
+"""
+
+import json
+import struct
+import sys
+from dataclasses import asdict, dataclass
+
+EVENT_FRAME = 0x01
+EVENT_DECODE_ERROR = 0x02
+EVENT_DROPS = 0x03
+EVENT_PAIRING = 0x04
+EVENT_RELEASE = 0x05
+
+FLAG_REPEATED = 0x01
+FLAG_EARLY = 0x02
+FLAG_COMBINED = 0x04
+FLAG_REPAIRED = 0x08
+
+BUTTONS = {
+    1: "MY",
+    2: "UP",
+    3: "MY+UP",
+    4: "DOWN",
+    5: "MY+DOWN",
+    6: "UP+DOWN",
+    7: "MY+UP+DOWN",
+    8: "PROG",
+}
+
+# rts_decode_status_t
+DECODE_STATUS = {
+    1: "ok",
+    2: "no_sync",
+    3: "truncated",
+    4: "bad_pulse",
+    5: "checksum",
+}
+
+RSSI_INVALID = -128
+
+
+@dataclass
+class FrameEvent:
+    address: int
+    rolling_code: int
+    button: int
+    flags: int
+    rssi: int
+    timestamp: int
+
+    @property
+    def button_name(self):
+        return BUTTONS.get(self.button, "?")
+
+
+@dataclass
+class DecodeErrorEvent:
+    status: int
+    flags: int
+    rssi: int
+    timestamp: int
+
+    @property
+    def status_name(self):
+        return DECODE_STATUS.get(self.status, "other")
+
+
+@dataclass
+class PairingEvent:
+    address: int
+    paired: bool
+
+
+@dataclass
+class ReleaseEvent:
+    address: int
+    button: int
+    repeats: int
+    held_us: int
+
+    @property
+    def button_name(self):
+        return BUTTONS.get(self.button, "?")
+
+
+@dataclass
+class DropsEvent:
+    rx_dropped: int
+    rx_lost: int
+    log_dropped: int
+    actuator_dropped: int
+    paired: int
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as computed by the bridge."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    """Decode one COBS frame, without its zero delimiter."""
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            raise ValueError("bad COBS code")
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_payload(payload):
+    """Turn a CRC-checked payload into an event, None for unknown types."""
+    kind = payload[0]
+    if kind == EVENT_FRAME and len(payload) == 12:
+        address = int.from_bytes(payload[1:4], "little")
+        rolling_code, button_flags, rssi, timestamp = struct.unpack_from(
+            "<HBbI", payload, 4)
+        return FrameEvent(address, rolling_code, button_flags & 0x0F,
+                          button_flags >> 4, rssi, timestamp)
+    if kind == EVENT_DECODE_ERROR and len(payload) == 8:
+        return DecodeErrorEvent(*struct.unpack_from("<BBbI", payload, 1))
+    if kind == EVENT_PAIRING and len(payload) == 5:
+        return PairingEvent(int.from_bytes(payload[1:4], "little"),
+                            payload[4] != 0)
+    if kind == EVENT_RELEASE and len(payload) == 11:
+        address = int.from_bytes(payload[1:4], "little")
+        return ReleaseEvent(address, *struct.unpack_from("<BHI", payload, 4))
+    if kind == EVENT_DROPS and len(payload) == 18:
+        return DropsEvent(*struct.unpack_from("<IIIIB", payload, 1))
+    return None
+
+
+class EventDecoder:
+    """Splits a byte stream into events. Damaged frames are skipped and
+    counted, and the decoder picks up again at the next delimiter."""
+
+    def __init__(self):
+        self._pending = bytearray()
+        self.bad_frames = 0
+        self.unknown_events = 0
+
+    def feed(self, data):
+        events = []
+        self._pending += data
+        while True:
+            end = self._pending.find(0)
+            if end < 0:
+                return events
+            frame = bytes(self._pending[:end])
+            del self._pending[:end + 1]
+            if not frame:
+                continue
+            event = self._decode(frame)
+            if event is not None:
+                events.append(event)
+
+    def _decode(self, frame):
+        try:
+            data = cobs_decode(frame)
+        except ValueError:
+            self.bad_frames += 1
+            return None
+        if len(data) < 3:
+            self.bad_frames += 1
+            return None
+        payload, crc = data[:-2], int.from_bytes(data[-2:], "little")
+        if crc16(payload) != crc:
+            self.bad_frames += 1
+            return None
+        event = parse_payload(payload)
+        if event is None:
+            self.unknown_events += 1
+        return event
+
+
+def to_json(event):
+    record = {"event": type(event).__name__}
+    record.update(asdict(event))
+    if isinstance(event, (FrameEvent, ReleaseEvent)):
+        record["button_name"] = event.button_name
+    elif isinstance(event, DecodeErrorEvent):
+        record["status_name"] = event.status_name
+    return json.dumps(record)
+
+
+def main(argv):
+    if len(argv) != 2:
+        print("usage: rts_events.py <port or capture file>", file=sys.stderr)
+        return 2
+    decoder = EventDecoder()
+    with open(argv[1], "rb", buffering=0) as source:
+        while True:
+            data = source.read(64)
+            if not data:
+                break
+            for event in decoder.feed(data):
+                print(to_json(event), flush=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,190 @@
+/***************************************************************************//**
+ * @file log_ring.c
+ * @brief Non-blocking log output, drained to the VCOM USART by LDMA
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "log_ring.h"
+#include "em_common.h"
+#include "em_device.h"
+#include "em_ldma.h"
+#include "sl_iostream.h"
+#include "sl_iostream_usart_vcom_config.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (LOG_RING_SIZE & (LOG_RING_SIZE - 1)) != 0
+#error "LOG_RING_SIZE must be a power of two"
+#endif
+
+// Indices run freely, so head - tail is always the fill level
+#define OFFSET(index) ((index) & (LOG_RING_SIZE - 1))
+
+// Whichever USART the VCOM instance is on, see
+// sl_iostream_usart_vcom_config.h. The LDMA signal is named after its number.
+#define LOG_USART      SL_IOSTREAM_USART_VCOM_PERIPHERAL
+#define LOG_DMA_SIGNAL                           \
+  SL_CONCAT_PASTER_3(ldmaPeripheralSignal_USART, \
+                     SL_IOSTREAM_USART_VCOM_PERIPHERAL_NO, _TXBL)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static sl_status_t log_write(void* context,
+                             const void* buffer,
+                             size_t buffer_length);
+static void start_transfer(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint8_t ring[LOG_RING_SIZE];
+// Bytes written into the buffer
+static uint32_t head = 0;
+// Bytes sent. Only moves on once the LDMA transfer of them is done, so the
+// writer can never overwrite bytes still on their way out.
+static uint32_t tail = 0;
+// Bytes in the LDMA transfer under way
+static uint32_t in_flight = 0;
+
+static uint32_t dropped = 0;
+static uint16_t max_fill = 0;
+
+static const LDMA_TransferCfg_t transfer_config =
+  LDMA_TRANSFER_CFG_PERIPHERAL(LOG_DMA_SIGNAL);
+// LDMA reads the descriptor while the transfer runs
+static LDMA_Descriptor_t descriptor;
+
+static sl_iostream_t log_stream = {
+  .context = NULL,
+  .write = log_write,
+  .read = NULL,
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Route stdout through the log buffer
+ *****************************************************************************/
+void log_ring_init(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_Init(&init);
+
+  sl_iostream_set_default(&log_stream);
+}
+
+/******************************************************************************
+ * Queue bytes for output (main loop)
+ *****************************************************************************/
+bool log_ring_write(const void* data, size_t length)
+{
+  uint32_t fill = head - tail;
+  if(length > LOG_RING_SIZE - fill) {
+    dropped += length;
+    return false;
+  }
+
+  uint32_t offset = OFFSET(head);
+  size_t first = LOG_RING_SIZE - offset;
+  if(first > length) {
+    first = length;
+  }
+  memcpy(&ring[offset], data, first);
+  memcpy(ring, (const uint8_t*)data + first, length - first);
+  head += length;
+
+  fill += length;
+  if(fill > max_fill) {
+    max_fill = (uint16_t)fill;
+  }
+
+  // Get the bytes moving right away if the USART is idle
+  log_ring_process();
+  return true;
+}
+
+/******************************************************************************
+ * Keep LDMA busy with whatever is buffered (main loop)
+ *****************************************************************************/
+void log_ring_process(void)
+{
+  if(in_flight != 0) {
+    if(!LDMA_TransferDone(LOG_RING_DMA_CHANNEL)) {
+      return;
+    }
+    tail += in_flight;
+    in_flight = 0;
+  }
+
+  start_transfer();
+}
+
+/******************************************************************************
+ * Get the log telemetry
+ *****************************************************************************/
+void log_ring_get_stats(log_ring_stats_t* stats)
+{
+  stats->written = head;
+  stats->dropped = dropped;
+  stats->fill = (uint16_t)(head - tail);
+  stats->max_fill = max_fill;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+// Write callback of the stdout stream, so it runs wherever printf() is called
+// from. That is the main loop only, as is everything else touching the ring.
+static sl_status_t log_write(void* context,
+                             const void* buffer,
+                             size_t buffer_length)
+{
+  (void) context;
+
+  // Logging is best effort, never make the caller wait for room
+  (void) log_ring_write(buffer, buffer_length);
+  return SL_STATUS_OK;
+}
+
+// Send the buffered bytes up to the end of the ring, the rest goes next time
+static void start_transfer(void)
+{
+  uint32_t pending = head - tail;
+  if(pending == 0) {
+    return;
+  }
+
+  uint32_t offset = OFFSET(tail);
+  if(pending > LOG_RING_SIZE - offset) {
+    pending = LOG_RING_SIZE - offset;
+  }
+
+  descriptor = (LDMA_Descriptor_t)
+               LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&ring[offset],
+                                               &LOG_USART->TXDATA,
+                                               pending);
+  in_flight = pending;
+  LDMA_StartTransfer(LOG_RING_DMA_CHANNEL, &transfer_config, &descriptor);
+}
@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file log_ring.h
+ * @brief Non-blocking log output, drained to the VCOM USART by LDMA
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Size of the log buffer in bytes, must be a power of two. Holds well over a
+/// second worth of 115200 baud output.
+#define LOG_RING_SIZE 2048
+
+/// LDMA channel used to drain the log buffer
+#define LOG_RING_DMA_CHANNEL 0
+
+/// Log telemetry
+typedef struct {
+  uint32_t written;               ///< Bytes accepted into the buffer
+  uint32_t dropped;               ///< Bytes thrown away because it was full
+  uint16_t fill;                  ///< Bytes waiting to be sent
+  uint16_t max_fill;              ///< Highest fill seen
+} log_ring_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Route stdout through the log buffer.
+ *
+ * Call once the VCOM USART is initialised. From then on printf() only copies
+ * into RAM, and LDMA feeds the USART in the background. Output that does not
+ * fit is dropped whole, so lines never come out garbled.
+ *****************************************************************************/
+void log_ring_init(void);
+
+/**************************************************************************//**
+ * Queue bytes for output. Main loop only, like printf().
+ *
+ * @param data Bytes to send
+ * @param length Number of bytes
+ * @returns true if queued, false if there was no room and nothing was queued
+ *****************************************************************************/
+bool log_ring_write(const void* data, size_t length);
+
+/**************************************************************************//**
+ * Hand the next stretch of buffered output to LDMA once the previous one is
+ * sent. Call from the main loop; it never waits.
+ *****************************************************************************/
+void log_ring_process(void);
+
+/**************************************************************************//**
+ * Get the log telemetry.
+ *
+ * @param stats Receives the telemetry
+ *****************************************************************************/
+void log_ring_get_stats(log_ring_stats_t* stats);
+
+#endif  // LOG_RING_H
@@ -0,0 +1,316 @@
+/***************************************************************************//**
+ * @file remote_table.c
+ * @brief Paired remotes, kept in NVM3 and looked up in RAM
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "remote_table.h"
+#include "nvm3_default.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+// Twice as many hash slots as remotes keeps probe sequences short
+#define SLOT_BITS  7
+#define SLOT_COUNT (1U << SLOT_BITS)
+#define SLOT_MASK  (SLOT_COUNT - 1)
+
+#if SLOT_COUNT < 2 * REMOTE_TABLE_CAPACITY
+#error "The hash table must be at most half full"
+#endif
+
+// Hash slot without a remote, and remote entry without an address
+#define SLOT_EMPTY   0xFF
+#define ADDRESS_FREE 0xFFFFFFFFUL
+
+#if REMOTE_TABLE_CODE_WINDOW <= REMOTE_TABLE_FLUSH_PRESSES
+#error "The boot time jump ahead must leave room in the code window"
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static inline unsigned int home_slot(uint32_t address);
+static unsigned int find_slot(uint32_t address);
+static void insert(uint8_t index);
+static bool store(uint8_t index);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// Remote 'i' is stored under NVM3 key REMOTE_TABLE_NVM3_KEY_BASE + i, so an
+// entry never moves once paired
+static remote_t remotes[REMOTE_TABLE_CAPACITY];
+// Open addressing with linear probing, each slot holds an index in remotes[]
+static uint8_t slots[SLOT_COUNT];
+static size_t count = 0;
+
+// Remotes whose rolling code changed since it was last stored
+static bool dirty[REMOTE_TABLE_CAPACITY];
+static size_t pending_presses = 0;
+static uint32_t pending_since;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Load the paired remotes from NVM3
+ *****************************************************************************/
+void remote_table_init(void)
+{
+  memset(slots, SLOT_EMPTY, sizeof(slots));
+  memset(dirty, 0, sizeof(dirty));
+  count = 0;
+  pending_presses = 0;
+
+  for(uint8_t i = 0; i < REMOTE_TABLE_CAPACITY; i++) {
+    remote_t record;
+    remotes[i].address = ADDRESS_FREE;
+
+    if(nvm3_readData(nvm3_defaultHandle,
+                     REMOTE_TABLE_NVM3_KEY_BASE + i,
+                     &record,
+                     sizeof(record)) == ECODE_NVM3_OK
+       && find_slot(record.address) == SLOT_COUNT) {
+      // Presses accepted after the last write of this code are lost, so
+      // skip the codes they might have used
+      record.rolling_code += REMOTE_TABLE_FLUSH_PRESSES;
+      remotes[i] = record;
+      insert(i);
+    }
+  }
+}
+
+/******************************************************************************
+ * Look up a remote
+ *****************************************************************************/
+const remote_t* remote_table_find(uint32_t address)
+{
+  unsigned int slot = find_slot(address);
+  return slot < SLOT_COUNT ? &remotes[slots[slot]] : NULL;
+}
+
+/******************************************************************************
+ * Check and use up the rolling code of a press
+ *****************************************************************************/
+remote_code_t remote_table_accept(const remote_t* remote,
+                                  uint16_t rolling_code,
+                                  uint32_t now)
+{
+  uint8_t index = (uint8_t)(remote - remotes);
+  uint16_t ahead = (uint16_t)(rolling_code - remotes[index].rolling_code);
+
+  if(ahead == 0) {
+    return REMOTE_CODE_REPEATED;
+  }
+  if(ahead > REMOTE_TABLE_CODE_WINDOW) {
+    return REMOTE_CODE_REJECTED;
+  }
+
+  remotes[index].rolling_code = rolling_code;
+  dirty[index] = true;
+  if(pending_presses++ == 0) {
+    pending_since = now;
+  }
+  return REMOTE_CODE_ACCEPTED;
+}
+
+/******************************************************************************
+ * Learn the timing of a paired remote
+ *****************************************************************************/
+void remote_table_learn_timing(const remote_t* remote, uint16_t hw_sync)
+{
+  uint8_t index = (uint8_t)(remote - remotes);
+  uint16_t learned = remotes[index].hw_sync;
+
+  if(hw_sync == 0) {
+    return;
+  }
+
+  // A first measurement, or a learned timing too far off to be right (the
+  // record may predate learning), is taken over as it is
+  if(learned == 0 || learned > 2 * hw_sync || hw_sync > 2 * learned) {
+    learned = hw_sync;
+  } else {
+    learned = (uint16_t)(learned + ((int32_t)hw_sync - learned)
+                                   / REMOTE_TABLE_TIMING_WEIGHT);
+  }
+
+  if(learned != remotes[index].hw_sync) {
+    remotes[index].hw_sync = learned;
+    dirty[index] = true;
+  }
+}
+
+/******************************************************************************
+ * Write piled up rolling codes to NVM3 (main loop)
+ *****************************************************************************/
+void remote_table_process(uint32_t now)
+{
+  if(pending_presses == 0
+     || (pending_presses < REMOTE_TABLE_FLUSH_PRESSES
+         && now - pending_since < REMOTE_TABLE_FLUSH_INTERVAL_US)) {
+    return;
+  }
+
+  pending_presses = 0;
+  for(uint8_t i = 0; i < REMOTE_TABLE_CAPACITY; i++) {
+    if(dirty[i]) {
+      if(store(i)) {
+        dirty[i] = false;
+      } else if(pending_presses++ == 0) {
+        // Try again once the interval has passed
+        pending_since = now;
+      }
+    }
+  }
+}
+
+/******************************************************************************
+ * Pair a remote
+ *****************************************************************************/
+bool remote_table_add(uint32_t address, uint16_t rolling_code)
+{
+  if(find_slot(address) < SLOT_COUNT) {
+    return true;
+  }
+
+  for(uint8_t i = 0; i < REMOTE_TABLE_CAPACITY; i++) {
+    if(remotes[i].address != ADDRESS_FREE) {
+      continue;
+    }
+
+    remotes[i].address = address;
+    remotes[i].rolling_code = rolling_code;
+    remotes[i].hw_sync = 0;
+    if(!store(i)) {
+      remotes[i].address = ADDRESS_FREE;
+      return false;
+    }
+
+    dirty[i] = false;
+    insert(i);
+    return true;
+  }
+
+  return false;
+}
+
+/******************************************************************************
+ * Unpair a remote
+ *****************************************************************************/
+bool remote_table_remove(uint32_t address)
+{
+  unsigned int hole = find_slot(address);
+  if(hole == SLOT_COUNT) {
+    return false;
+  }
+
+  uint8_t index = slots[hole];
+  nvm3_deleteObject(nvm3_defaultHandle, REMOTE_TABLE_NVM3_KEY_BASE + index);
+  remotes[index].address = ADDRESS_FREE;
+  dirty[index] = false;
+  count--;
+
+  // Shift later entries of the probe sequence back into the hole, so lookups
+  // can keep stopping at the first empty slot
+  unsigned int slot = hole;
+  for(;;) {
+    slot = (slot + 1) & SLOT_MASK;
+    if(slots[slot] == SLOT_EMPTY) {
+      break;
+    }
+    unsigned int home = home_slot(remotes[slots[slot]].address);
+    // The entry can move if its home slot is not cyclically in (hole, slot]
+    if(((slot - home) & SLOT_MASK) >= ((slot - hole) & SLOT_MASK)) {
+      slots[hole] = slots[slot];
+      hole = slot;
+    }
+  }
+  slots[hole] = SLOT_EMPTY;
+
+  return true;
+}
+
+/******************************************************************************
+ * Walk the paired remotes
+ *****************************************************************************/
+const remote_t* remote_table_next(const remote_t* remote)
+{
+  size_t i = remote == NULL ? 0 : (size_t)(remote - remotes) + 1;
+
+  for(; i < REMOTE_TABLE_CAPACITY; i++) {
+    if(remotes[i].address != ADDRESS_FREE) {
+      return &remotes[i];
+    }
+  }
+  return NULL;
+}
+
+/******************************************************************************
+ * Get the number of paired remotes
+ *****************************************************************************/
+size_t remote_table_count(void)
+{
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+// Fibonacci hashing, spreads neighbouring addresses over the whole table
+static inline unsigned int home_slot(uint32_t address)
+{
+  return (unsigned int)((uint32_t)(address * 0x9E3779B1UL) >> (32 - SLOT_BITS));
+}
+
+// Slot holding 'address', SLOT_COUNT if there is none
+static unsigned int find_slot(uint32_t address)
+{
+  for(unsigned int slot = home_slot(address);; slot = (slot + 1) & SLOT_MASK) {
+    uint8_t index = slots[slot];
+    if(index == SLOT_EMPTY) {
+      return SLOT_COUNT;
+    }
+    if(remotes[index].address == address) {
+      return slot;
+    }
+  }
+}
+
+static void insert(uint8_t index)
+{
+  unsigned int slot = home_slot(remotes[index].address);
+  while(slots[slot] != SLOT_EMPTY) {
+    slot = (slot + 1) & SLOT_MASK;
+  }
+  slots[slot] = index;
+  count++;
+}
+
+static bool store(uint8_t index)
+{
+  return nvm3_writeData(nvm3_defaultHandle,
+                        REMOTE_TABLE_NVM3_KEY_BASE + index,
+                        &remotes[index],
+                        sizeof(remotes[index])) == ECODE_NVM3_OK;
+}
@@ -0,0 +1,157 @@
+/***************************************************************************//**
+ * @file remote_table.h
+ * @brief Paired remotes, kept in NVM3 and looked up in RAM
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef REMOTE_TABLE_H
+#define REMOTE_TABLE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of remotes the bridge can be paired with
+#define REMOTE_TABLE_CAPACITY 64
+
+/// Each paired remote is one NVM3 object, keyed from this base up
+#define REMOTE_TABLE_NVM3_KEY_BASE 0x01000
+
+/// A press is accepted if its rolling code is at most this far past the last
+/// accepted one, which covers presses made out of range of the bridge
+#define REMOTE_TABLE_CODE_WINDOW 100
+
+/// Accepted rolling codes are only kept in RAM until this many presses have
+/// piled up, or until REMOTE_TABLE_FLUSH_INTERVAL_US after the first of them.
+/// At boot every stored code is moved this many presses ahead, so codes
+/// accepted but not yet stored when power was lost cannot be replayed. The
+/// price is that after a power cut, a remote may need that many presses
+/// before it is heard again.
+#define REMOTE_TABLE_FLUSH_PRESSES 4
+#define REMOTE_TABLE_FLUSH_INTERVAL_US 10000000UL
+
+/// Each accepted press moves the learned timing of its remote this fraction
+/// of the way to what was measured on the press, which evens out the jitter
+/// of single frames
+#define REMOTE_TABLE_TIMING_WEIGHT 8
+
+/// A paired remote, as stored in NVM3
+typedef struct {
+  uint32_t address;               ///< Remote address, 24 bits
+  uint16_t rolling_code;          ///< Last accepted rolling code
+  uint16_t hw_sync;               ///< Learned HW sync pulse length, in 1/32
+                                  ///< samples (see rts_frame_t), 0 if none
+} remote_t;
+
+/// Verdict on the rolling code of a press
+typedef enum {
+  REMOTE_CODE_ACCEPTED = 0,       ///< New press, the code is now used up
+  REMOTE_CODE_REPEATED,           ///< Same code as the last accepted press
+  REMOTE_CODE_REJECTED,           ///< Replayed, or too far ahead
+} remote_code_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Load the paired remotes from NVM3. Call once at boot, after NVM3 is up.
+ *****************************************************************************/
+void remote_table_init(void);
+
+/**************************************************************************//**
+ * Look up a remote.
+ *
+ * @param address Remote address
+ * @returns The paired remote, or NULL if the remote is not paired
+ *
+ * The hash table is at most half full, so an unknown remote is nearly always
+ * turned away after looking at a single slot.
+ *****************************************************************************/
+const remote_t* remote_table_find(uint32_t address);
+
+/**************************************************************************//**
+ * Check the rolling code of a press from a paired remote, and use it up if it
+ * is accepted.
+ *
+ * @param remote Paired remote, as returned by remote_table_find()
+ * @param rolling_code Rolling code of the press
+ * @param now Current time in us, wrapping
+ * @returns Verdict
+ *
+ * Only touches RAM, accepted codes are written to NVM3 later on by
+ * remote_table_process().
+ *****************************************************************************/
+remote_code_t remote_table_accept(const remote_t* remote,
+                                  uint16_t rolling_code,
+                                  uint32_t now);
+
+/**************************************************************************//**
+ * Update the learned timing of a paired remote with the HW sync pulse length
+ * measured on a press of it.
+ *
+ * @param remote Paired remote, as returned by remote_table_find()
+ * @param hw_sync Measured HW sync pulse length in 1/32 samples, 0 if none
+ *
+ * Only touches RAM. The timing is written to NVM3 along with the rolling
+ * code, so learning it costs no extra writes.
+ *****************************************************************************/
+void remote_table_learn_timing(const remote_t* remote, uint16_t hw_sync);
+
+/**************************************************************************//**
+ * Write accepted rolling codes to NVM3 once enough of them have piled up, or
+ * they have waited long enough. Call from the main loop.
+ *
+ * @param now Current time in us, wrapping
+ *****************************************************************************/
+void remote_table_process(uint32_t now);
+
+/**************************************************************************//**
+ * Pair a remote and store it in NVM3.
+ *
+ * @param address Remote address
+ * @param rolling_code Rolling code of the pairing press
+ * @returns true if paired (or already was), false if the table is full or
+ *          the remote could not be stored
+ *****************************************************************************/
+bool remote_table_add(uint32_t address, uint16_t rolling_code);
+
+/**************************************************************************//**
+ * Unpair a remote and delete it from NVM3.
+ *
+ * @param address Remote address
+ * @returns true if the remote was paired
+ *****************************************************************************/
+bool remote_table_remove(uint32_t address);
+
+/**************************************************************************//**
+ * Walk the paired remotes.
+ *
+ * @param remote Remote returned by the previous call, NULL to start
+ * @returns The next paired remote, NULL after the last one
+ *****************************************************************************/
+const remote_t* remote_table_next(const remote_t* remote);
+
+/**************************************************************************//**
+ * Get the number of paired remotes.
+ *
+ * @returns Number of paired remotes
+ *****************************************************************************/
+size_t remote_table_count(void);
+
+#endif  // REMOTE_TABLE_H
@@ -0,0 +1,1128 @@
+/***************************************************************************//**
+ * @file rts_decoder.c
+ * @brief Somfy RTS frame decoder
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "rts_decoder.h"
+#include "em_device.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+// Valid Somfy RTS SW sync pulse length, in oversampled bits, for a remote
+// running at the nominal rate. See update_timing() for the limits once the HW
+// sync pulses of a frame have been measured.
+#define SW_SYNC_MIN 28
+#define SW_SYNC_MAX 36
+
+// A HW sync pulse (high or low) is 4 half-bits, 15.5 samples nominally. Runs
+// this far off are not taken for one when measuring the remote's timing. A
+// glitch too wide for the glitch filter takes 3 samples or more off a pulse,
+// which puts it outside.
+#define HW_SYNC_MIN 13
+#define HW_SYNC_MAX 18
+// Sync pulse lengths are summed in 1/32 of a HW sync pulse. A SW sync pulse
+// is 4550 us against 2416 us for a HW sync pulse, so it counts 17/32 of its
+// length.
+#define HW_SYNC_WEIGHT 32
+#define SW_SYNC_WEIGHT 17
+
+// The syncword only matches the first HW sync pulse coarsely, so the SW sync
+// is found by sliding the sync template of each protocol along the runs. A
+// template may mismatch at most 1/N of its length, which leaves room for
+// jitter at every edge and a glitch too wide for the glitch filter, but not
+// for being a pulse off.
+#define SYNC_MISMATCH_DIV 5
+// The SW sync of a first frame starts about 39 samples into the capture, the
+// one of a repeated frame, with its 5 more HW sync pulses, about 194
+#define REPEAT_SYNC_START 100
+// Samples into the capture by which the SW sync of a repeated frame has
+// ended, even from a slow remote
+#define SYNC_SEARCH_END 256
+
+#if (RTS_LOOKUP_BITS % 8) != 0 || RTS_LOOKUP_BITS >= RTS_FRAME_BITS
+#error "The frame lookup must happen on a byte boundary inside the frame"
+#endif
+
+// Frame formats, see frame_format_t. The obfuscation and the checksum of an
+// extended frame run on over the 24 bits after the first 56. An extended
+// frame is only known to be one after 56 bits, so it is not looked up.
+#define FORMAT_RTS ((frame_format_t){ .bits = RTS_FRAME_BITS,             \
+                                      .checksum_bytes = RTS_FRAME_BYTES, \
+                                      .lookup_bits = RTS_LOOKUP_BITS })
+#define FORMAT_EXT ((frame_format_t){ .bits = RTS_EXT_FRAME_BITS,             \
+                                      .checksum_bytes = RTS_EXT_FRAME_BYTES, \
+                                      .lookup_bits = 0 })
+
+// A Manchester run at least this long spans two half-bits, and one longer than
+// LONG_RUN_MAX cannot be part of a frame at all. Nominal rate, as above.
+#define LONG_RUN_MIN 6
+#define LONG_RUN_MAX 11
+
+// Run length classes, see quantise_run()
+#define RUN_SHORT   0
+#define RUN_LONG    1
+#define RUN_INVALID 2
+
+// Runs of a frame which failed its checksum that are read as the other
+// length class, one at a time, and how far from the long run limit a run may
+// be to be tried. Every try is a 1 in 16 chance of passing the checksum by
+// accident, so there are only a few.
+#define REPAIR_RUNS           3
+#define REPAIR_MAX_CONFIDENCE 1
+
+// Manchester transition table entries: the bit to emit, whether the run after
+// this one has to be eaten first, or that the run breaks the frame
+#define EMIT_0   0x00
+#define EMIT_1   0x01
+#define SKIP_RUN 0x02
+#define BAD_RUN  0x04
+
+#if defined(RTS_DECODER_PROFILE)
+#define PROFILE_STAGE(stage) rts_decoder_profile_stage(stage)
+#else
+#define PROFILE_STAGE(stage)
+#endif
+
+// Decoder states
+enum {
+  STATE_SW_SYNC,
+  STATE_HUNT,
+  STATE_DATA,
+  STATE_EXTENDED,
+  STATE_REPAIR,
+  STATE_DONE,
+};
+
+// Layout of a frame. Formats are only ever handed as constants to functions
+// which are forced inline, so each format gets a copy of the Manchester and
+// checksum code with its frame length folded in.
+typedef struct {
+  uint8_t bits;           // Frame bits
+  uint8_t checksum_bytes; // Leading bytes of the frame the checksum covers
+  uint8_t lookup_bits;    // Bits after which the frame is looked up, 0 never
+} frame_format_t;
+
+// Least certain runs which decided a bit, least certain first
+typedef struct {
+  size_t run[REPAIR_RUNS];
+  unsigned int confidence[REPAIR_RUNS];
+  size_t count;
+} weak_runs_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void feed_bytes(rts_decoder_t* decoder,
+                       const uint8_t* samples,
+                       size_t length);
+static void push_word(rts_decoder_t* decoder, uint32_t word);
+static void decode_word(rts_decoder_t* decoder, uint32_t next, size_t bits);
+static uint32_t filter_word(uint32_t prev, uint32_t cur, uint32_t next);
+static rts_decode_status_t push_run(rts_decoder_t* decoder,
+                                    unsigned int level,
+                                    size_t length);
+static rts_decode_status_t handle_run(rts_decoder_t* decoder, uint8_t run);
+static rts_decode_status_t catch_up(rts_decoder_t* decoder,
+                                    rts_decode_status_t status);
+static rts_decode_status_t on_run(rts_decoder_t* decoder, uint8_t run);
+static rts_decode_status_t hunt_sync(rts_decoder_t* decoder, uint8_t run);
+static void take_sync(rts_decoder_t* decoder);
+static rts_decode_status_t next_frame(rts_decoder_t* decoder,
+                                      rts_decode_status_t status);
+static void clear_frame(rts_decoder_t* decoder);
+static unsigned int find_sync(const rts_decoder_t* decoder,
+                              uint32_t* mismatch);
+static uint32_t correlate_sync(const rts_decoder_t* decoder,
+                               const rts_protocol_t* protocol,
+                               uint32_t hw_sync,
+                               uint32_t limit);
+static void start_data(rts_decoder_t* decoder,
+                       unsigned int protocol,
+                       size_t length);
+static void add_sync(rts_decoder_t* decoder, size_t length, uint32_t weight);
+static void update_timing(rts_decoder_t* decoder);
+static inline unsigned int quantise_run(const rts_decoder_t* decoder,
+                                        size_t length);
+static rts_decode_status_t somfy_run(rts_decoder_t* decoder, uint8_t run);
+static rts_decode_status_t extended_run(rts_decoder_t* decoder, uint8_t run);
+__STATIC_FORCEINLINE rts_decode_status_t manchester_run(rts_decoder_t* decoder,
+                                                        uint8_t run,
+                                                        frame_format_t format);
+__STATIC_FORCEINLINE rts_decode_status_t emit_bit(rts_decoder_t* decoder,
+                                                  unsigned int bit,
+                                                  frame_format_t format);
+static rts_decode_status_t end_frame(rts_decoder_t* decoder, uint8_t run);
+static rts_decode_status_t repair_frame(rts_decoder_t* decoder);
+static bool repair(rts_decoder_t* decoder, frame_format_t format, size_t end);
+static bool redecode(rts_decoder_t* decoder,
+                     frame_format_t format,
+                     size_t end,
+                     size_t flip,
+                     weak_runs_t* weak);
+static void add_weak(weak_runs_t* weak, size_t run, unsigned int confidence);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+// Indexed by the previous decoded bit and the class of the run starting in the
+// middle of that bit.
+static const uint8_t manchester_table[2][4] = {
+  // Previous bit was a 0 (1->0), so if the next edge is at 4 the next bit is
+  // also a 0 and the edge after that is another middle of a Manchester bit.
+  // If the next edge is at 8 it already is that middle, and the bit is a 1.
+  { EMIT_0 | SKIP_RUN, EMIT_1, BAD_RUN, BAD_RUN },
+  // Previous bit was a 1 (0->1), so if the next edge is at 4 this bit is a 1
+  // too. If the next edge is at 8 the next bit is a 0.
+  { EMIT_1 | SKIP_RUN, EMIT_0, BAD_RUN, BAD_RUN },
+};
+
+// The last HW sync pulse, high and low, and the SW sync pulse. The SW sync
+// pulse is 4550 us against 2416 us for a HW sync pulse.
+static const rts_sync_pulse_t somfy_sync[] = {
+  { .level = 1, .length = 32 },
+  { .level = 0, .length = 32 },
+  { .level = 1, .length = 60 },
+};
+
+static const rts_protocol_t somfy_protocol = {
+  .sync = somfy_sync,
+  .sync_pulses = sizeof(somfy_sync) / sizeof(somfy_sync[0]),
+  .sw_sync_min = SW_SYNC_MIN,
+  .sw_sync_max = SW_SYNC_MAX,
+  .sw_sync_weight = SW_SYNC_WEIGHT,
+  .on_run = somfy_run,
+};
+
+// Every protocol the decoder knows, indexed by rts_protocol_id_t. A protocol
+// decoded elsewhere is added here with the id it gets in rts_decoder.h.
+static const rts_protocol_t* const protocols[RTS_PROTOCOL_COUNT] = {
+  [RTS_PROTOCOL_SOMFY] = &somfy_protocol,
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Decode an oversampled RTS capture in a single pass
+ *****************************************************************************/
+rts_decode_status_t rts_decode_capture(rts_decoder_t* decoder,
+                                       const rts_capture_t* capture)
+{
+  rts_decoder_start(decoder);
+  rts_decoder_feed(decoder, capture);
+  return rts_decoder_finish(decoder);
+}
+
+/******************************************************************************
+ * Start decoding a new capture
+ *****************************************************************************/
+void rts_decoder_start(rts_decoder_t* decoder)
+{
+  decoder->run_count = 0;
+  decoder->runs_kept = 0;
+
+  decoder->bytes = 0;
+  decoder->word_start = 0;
+  decoder->run_start = 0;
+  decoder->level = 0;
+  decoder->status = RTS_DECODE_BUSY;
+  decoder->first_status = RTS_DECODE_BUSY;
+  decoder->failed_count = 0;
+
+  decoder->sync_sum = 0;
+  decoder->sync_count = 0;
+  for(size_t i = 0; i < RTS_PROTOCOL_COUNT; i++) {
+    decoder->sw_sync_min[i] = protocols[i]->sw_sync_min;
+    decoder->sw_sync_max[i] = protocols[i]->sw_sync_max;
+  }
+  decoder->long_run_min = LONG_RUN_MIN;
+  decoder->long_run_max = LONG_RUN_MAX;
+
+  decoder->state = STATE_SW_SYNC;
+  decoder->skip = 0;
+  decoder->protocol = RTS_PROTOCOL_SOMFY;
+  decoder->sync_protocol = RTS_PROTOCOL_COUNT;
+  clear_frame(decoder);
+  decoder->frame.repeated = false;
+  decoder->frame.protocol = RTS_PROTOCOL_SOMFY;
+}
+
+/******************************************************************************
+ * Start decoding samples which begin right after a SW sync
+ *****************************************************************************/
+void rts_decoder_start_frame(rts_decoder_t* decoder)
+{
+  rts_decoder_start(decoder);
+  decoder->state = STATE_DATA;
+  decoder->skip = 0;
+  decoder->frame_run = 0;
+}
+
+/******************************************************************************
+ * Set the decoder up for the timing of a known remote
+ *****************************************************************************/
+bool rts_decoder_set_timing(rts_decoder_t* decoder, uint16_t hw_sync)
+{
+  if(hw_sync < HW_SYNC_MIN * HW_SYNC_WEIGHT
+     || hw_sync > HW_SYNC_MAX * HW_SYNC_WEIGHT) {
+    return false;
+  }
+
+  decoder->sync_sum = hw_sync;
+  decoder->sync_count = 1;
+  update_timing(decoder);
+  return true;
+}
+
+/******************************************************************************
+ * Get the HW sync pulse length measured so far
+ *****************************************************************************/
+uint16_t rts_decoder_hw_sync(const rts_decoder_t* decoder)
+{
+  return decoder->sync_count == 0
+         ? 0 : (uint16_t)(decoder->sync_sum / decoder->sync_count);
+}
+
+/******************************************************************************
+ * Decode the part of a capture that has not been fed yet
+ *****************************************************************************/
+rts_decode_status_t rts_decoder_feed(rts_decoder_t* decoder,
+                                     const rts_capture_t* capture)
+{
+  // The packet data received begins at a pretty specific location due to how
+  // the receiver is limited in setting preamble / syncword.
+  //
+  // +-----+     +-----+     +---------+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  // + hw1 +-----+ hw2 +-----+ swsync  +--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+---------
+  //          ^
+  //      buffer start
+  //
+  // Received buffer is oversampled with 4x due to the pretty ridiculous
+  // tolerance on the sent data.
+  //
+  // This means we need to stretch/shorten as needed in order to decode the
+  // actual packet bits.
+  PROFILE_STAGE(RTS_STAGE_RUN_EXTRACTION);
+
+  size_t first_length = capture->first_length < capture->length
+                        ? capture->first_length : capture->length;
+
+  if(decoder->bytes < first_length) {
+    feed_bytes(decoder,
+               &capture->first[decoder->bytes],
+               first_length - decoder->bytes);
+  }
+  // A capture which claims to go on past its first portion, but has no
+  // second one, ends with the first
+  if(decoder->status == RTS_DECODE_BUSY
+     && decoder->bytes < capture->length
+     && capture->last != NULL) {
+    feed_bytes(decoder,
+               &capture->last[decoder->bytes - first_length],
+               capture->length - decoder->bytes);
+  }
+
+  return (rts_decode_status_t)decoder->status;
+}
+
+/******************************************************************************
+ * Decode the rest of a capture once it is complete
+ *****************************************************************************/
+rts_decode_status_t rts_decoder_finish(rts_decoder_t* decoder)
+{
+  if(decoder->status != RTS_DECODE_BUSY) {
+    return (rts_decode_status_t)decoder->status;
+  }
+
+  if(decoder->bytes == 0) {
+    decoder->status = RTS_DECODE_NO_SYNC;
+    return RTS_DECODE_NO_SYNC;
+  }
+
+  PROFILE_STAGE(RTS_STAGE_RUN_EXTRACTION);
+
+  // Samples past the end of the capture repeat the last one, so that the end
+  // of the capture never looks like an edge to the glitch filter
+  size_t bits = decoder->bytes * 8;
+  size_t tail = bits % 32;
+
+  if(tail != 0) {
+    uint32_t fill = 0UL - (decoder->partial & 1);
+    uint32_t word = (decoder->partial << (32 - tail))
+                    | (fill >> tail);
+    if(bits < 32) {
+      push_word(decoder, word);
+    } else {
+      decode_word(decoder, word, bits);
+    }
+  }
+
+  if(decoder->status == RTS_DECODE_BUSY) {
+    decode_word(decoder, 0UL - (decoder->cur & 1), bits);
+  }
+
+  if(decoder->status == RTS_DECODE_BUSY) {
+    // The last run is cut short by the end of the capture
+    decoder->status = push_run(decoder,
+                               decoder->level,
+                               bits - decoder->run_start);
+  }
+
+  if(decoder->status == RTS_DECODE_BUSY
+     && decoder->sync_protocol < RTS_PROTOCOL_COUNT) {
+    // No later edge can match the sync template better any more
+    take_sync(decoder);
+    decoder->status = catch_up(decoder, RTS_DECODE_BUSY);
+  }
+
+  if(decoder->status == RTS_DECODE_BUSY
+     && (decoder->state == STATE_REPAIR || decoder->state == STATE_EXTENDED)) {
+    // The capture ended right after a frame which failed its checksum, or
+    // in what was taken for the rest of an extended frame
+    decoder->status = repair_frame(decoder);
+    if(decoder->status != RTS_DECODE_OK) {
+      decoder->status = next_frame(decoder, RTS_DECODE_CHECKSUM);
+    }
+  }
+
+  if(decoder->status == RTS_DECODE_BUSY) {
+    // The frame the capture ended in failed too
+    if(decoder->state == STATE_DATA) {
+      decoder->failed_count++;
+    }
+
+    if(decoder->first_status != RTS_DECODE_BUSY) {
+      // No later frame made up for the first one, report what was wrong
+      // with that
+      decoder->status = decoder->first_status;
+    } else {
+      decoder->status = decoder->state == STATE_SW_SYNC
+                        ? RTS_DECODE_NO_SYNC : RTS_DECODE_TRUNCATED;
+    }
+  }
+
+  return (rts_decode_status_t)decoder->status;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+// Gather the samples into 32-bit words, with the earliest received sample as
+// the MSB. Whole words are loaded in one go where the chunk allows it.
+static void feed_bytes(rts_decoder_t* decoder,
+                       const uint8_t* samples,
+                       size_t length)
+{
+  while(length > 0 && decoder->status == RTS_DECODE_BUSY) {
+    if((decoder->bytes % 4) == 0 && length >= 4) {
+      uint32_t raw;
+      memcpy(&raw, samples, sizeof(raw));
+      decoder->bytes += 4;
+      push_word(decoder, __REV(raw));
+      samples += 4;
+      length -= 4;
+    } else {
+      decoder->partial = (decoder->partial << 8) | *samples++;
+      decoder->bytes++;
+      length--;
+      if((decoder->bytes % 4) == 0) {
+        push_word(decoder, decoder->partial);
+      }
+    }
+  }
+}
+
+// Take in the next whole word of samples. A word is glitch filtered and
+// decoded once the word after it is in, as the filter needs a bit of context
+// from both neighbours.
+static void push_word(rts_decoder_t* decoder, uint32_t word)
+{
+  if(decoder->bytes <= 4) {
+    // Before the capture, the first sample is repeated so that the run it
+    // starts can never be filtered away
+    decoder->cur = word;
+    decoder->level = (uint8_t)(word >> 31);
+    decoder->prev = 0UL - decoder->level;
+    return;
+  }
+
+  decode_word(decoder, word, SIZE_MAX);
+}
+
+// Filter the pending word and turn its edges into runs, ignoring edges at or
+// past sample 'bits'. 'next' becomes the pending word.
+static void decode_word(rts_decoder_t* decoder, uint32_t next, size_t bits)
+{
+  PROFILE_STAGE(RTS_STAGE_GLITCH_FILTER);
+  uint32_t samples = filter_word(decoder->prev, decoder->cur, next);
+  PROFILE_STAGE(RTS_STAGE_RUN_EXTRACTION);
+
+  size_t word_start = decoder->word_start;
+  unsigned int level = decoder->level;
+  rts_decode_status_t status = RTS_DECODE_BUSY;
+
+  decoder->prev = decoder->cur;
+  decoder->cur = next;
+  decoder->word_start += 32;
+
+  // Set bits mark samples which differ from the current level, so CLZ
+  // jumps straight to the next edge.
+  uint32_t diff = samples ^ (0UL - level);
+  uint32_t pending = 0xFFFFFFFFUL;
+
+  while((diff & pending) != 0 && status == RTS_DECODE_BUSY) {
+    size_t edge = word_start + __CLZ(diff & pending);
+    if(edge >= bits) {
+      break;
+    }
+
+    status = push_run(decoder, level, edge - decoder->run_start);
+    decoder->run_start = edge;
+    level ^= 1;
+    diff = ~diff;
+    pending = 0xFFFFFFFFUL >> (edge % 32);
+  }
+
+  if(status == RTS_DECODE_BUSY
+     && decoder->frame_valid
+     && (decoder->state == STATE_REPAIR || decoder->state == STATE_EXTENDED)
+     && decoder->word_start - decoder->run_start > decoder->long_run_max) {
+    // After a frame which passed its checksum after 56 bits, the current run
+    // is already too long to be part of an extended frame. The verdict does
+    // not depend on how long it gets, so it need not end first.
+    status = repair_frame(decoder);
+  }
+
+  decoder->level = (uint8_t)level;
+  decoder->status = status;
+}
+
+// Glitch filter for the 32 samples in 'cur', working on all of them at once.
+// A morphological opening with a 3 sample wide element removes high pulses of
+// 1 or 2 samples, and the closing after it fills low gaps of 1 or 2 samples.
+// Longer pulses come out unchanged. Each output sample depends on the 4
+// samples either side, which 16 bits of context from each neighbour cover.
+static uint32_t filter_word(uint32_t prev, uint32_t cur, uint32_t next)
+{
+  uint64_t x = ((uint64_t)(prev & 0xFFFFUL) << 48)
+               | ((uint64_t)cur << 16)
+               | (next >> 16);
+
+  // Opening: erode, then dilate
+  x = x & (x >> 1) & (x << 1);
+  x = x | (x >> 1) | (x << 1);
+  // Closing: dilate, then erode
+  x = x | (x >> 1) | (x << 1);
+  x = x & (x >> 1) & (x << 1);
+
+  return (uint32_t)(x >> 16);
+}
+
+// Append a run and pass it on to the state machine
+static rts_decode_status_t push_run(rts_decoder_t* decoder,
+                                    unsigned int level,
+                                    size_t length)
+{
+  if(length > RTS_RUN_LENGTH_MAX) {
+    length = RTS_RUN_LENGTH_MAX;
+  }
+
+  uint8_t run = (uint8_t)((level << 7) | length);
+  if(decoder->run_count < RTS_MAX_RUNS) {
+    decoder->runs[decoder->run_count++] = run;
+    decoder->runs_kept = decoder->run_count;
+  } else if(decoder->state == STATE_SW_SYNC || decoder->state == STATE_HUNT) {
+    // Without the runs to lay the sync template over, no later frame can be
+    // found. Give up on a jammed capture here rather than at its end.
+    decoder->state = STATE_DONE;
+    return decoder->first_status != RTS_DECODE_BUSY
+           ? (rts_decode_status_t)decoder->first_status : RTS_DECODE_NO_SYNC;
+  }
+
+  size_t run_start = decoder->run_start;
+  rts_decode_status_t status = catch_up(decoder, handle_run(decoder, run));
+  decoder->run_start = run_start;
+  PROFILE_STAGE(RTS_STAGE_RUN_EXTRACTION);
+  return status;
+}
+
+// Pass a run on to the state machine, and after a verdict on a frame which
+// failed, on to the next frame
+static rts_decode_status_t handle_run(rts_decoder_t* decoder, uint8_t run)
+{
+  rts_decode_status_t status = on_run(decoder, run);
+  if(status > RTS_DECODE_OK) {
+    status = next_frame(decoder, status);
+  }
+  return status;
+}
+
+// A SW sync taken after later runs came in winds run_count and run_start
+// back to the run after it. Hand the runs since on again, now to the frame.
+static rts_decode_status_t catch_up(rts_decoder_t* decoder,
+                                    rts_decode_status_t status)
+{
+  while(status == RTS_DECODE_BUSY
+        && decoder->run_count < decoder->runs_kept) {
+    size_t index = decoder->run_count++;
+    uint8_t run = decoder->runs[index];
+    status = handle_run(decoder, run);
+    if(decoder->run_count == index + 1) {
+      decoder->run_start += RTS_RUN_LENGTH(run);
+    }
+  }
+  return status;
+}
+
+static rts_decode_status_t on_run(rts_decoder_t* decoder, uint8_t run)
+{
+  size_t length = RTS_RUN_LENGTH(run);
+
+  PROFILE_STAGE(decoder->state == STATE_DATA
+                || decoder->state == STATE_EXTENDED
+                ? RTS_STAGE_MANCHESTER : RTS_STAGE_SYNC_SEARCH);
+
+  // Every whole run ahead of the SW sync is a HW sync pulse. The first run
+  // of the capture starts part way into one.
+  if(decoder->state == STATE_SW_SYNC && decoder->run_count > 1
+     && length >= HW_SYNC_MIN && length <= HW_SYNC_MAX) {
+    add_sync(decoder, length, HW_SYNC_WEIGHT);
+  }
+
+  if(decoder->skip > 0) {
+    decoder->skip--;
+    // Where an extended frame may have ended after 56 bits, the run eaten
+    // may be the gap after it
+    if(decoder->state == STATE_EXTENDED
+       && quantise_run(decoder, length) == RUN_INVALID) {
+      return repair_frame(decoder);
+    }
+    return RTS_DECODE_BUSY;
+  }
+
+  switch(decoder->state) {
+    case STATE_SW_SYNC:
+    case STATE_HUNT:
+      return hunt_sync(decoder, run);
+
+    case STATE_DATA:
+      return protocols[decoder->protocol]->on_run(decoder, run);
+
+    case STATE_EXTENDED:
+      return extended_run(decoder, run);
+
+    case STATE_REPAIR:
+      return end_frame(decoder, run);
+
+    default:
+      return RTS_DECODE_BUSY;
+  }
+}
+
+// Look for the falling edge of a SW sync. In STATE_HUNT, the repeat comes from
+// the same remote, so the timing measured on the frame before it still holds.
+static rts_decode_status_t hunt_sync(rts_decoder_t* decoder, uint8_t run)
+{
+  size_t length = RTS_RUN_LENGTH(run);
+
+  if(RTS_RUN_LEVEL(run) == 1) {
+    uint32_t mismatch;
+    unsigned int protocol = find_sync(decoder, &mismatch);
+    if(protocol < RTS_PROTOCOL_COUNT
+       && (decoder->sync_protocol == RTS_PROTOCOL_COUNT
+           || mismatch < decoder->sync_mismatch)) {
+      // An edge further on can only match better if it is at most as many
+      // samples away as this one mismatched
+      decoder->sync_protocol = (uint8_t)protocol;
+      decoder->sync_length = (uint8_t)length;
+      decoder->sync_run = decoder->run_count - 1;
+      decoder->sync_start = decoder->run_start;
+      decoder->sync_until = decoder->run_start + length + (mismatch + 31) / 32;
+      decoder->sync_mismatch = mismatch;
+      return RTS_DECODE_BUSY;
+    }
+  }
+
+  if(decoder->sync_protocol < RTS_PROTOCOL_COUNT) {
+    if(decoder->run_start + length > decoder->sync_until) {
+      take_sync(decoder);
+    }
+    return RTS_DECODE_BUSY;
+  }
+
+  return decoder->state == STATE_SW_SYNC
+         && decoder->run_start + length > SYNC_SEARCH_END
+         ? RTS_DECODE_NO_SYNC : RTS_DECODE_BUSY;
+}
+
+// Start the frame after the best SW sync found, and wind the runs back to the
+// first one after it, see catch_up()
+static void take_sync(rts_decoder_t* decoder)
+{
+  unsigned int protocol = decoder->sync_protocol;
+  size_t length = decoder->sync_length;
+
+  decoder->sync_protocol = RTS_PROTOCOL_COUNT;
+  decoder->run_count = decoder->sync_run + 1;
+  decoder->run_start = decoder->sync_start;
+
+  if(decoder->state == STATE_SW_SYNC) {
+    // A glitch may have cut the pulse short, then it is not measured
+    if(protocols[protocol]->sw_sync_weight != 0
+       && length >= decoder->sw_sync_min[protocol]
+       && length <= decoder->sw_sync_max[protocol]) {
+      add_sync(decoder, length, protocols[protocol]->sw_sync_weight);
+    }
+    decoder->frame.repeated = decoder->run_start > REPEAT_SYNC_START;
+  }
+  start_data(decoder, protocol, length);
+  decoder->run_start += length;
+}
+
+// A frame did not decode. The remote repeats it after a gap, and the capture
+// may well be long enough to hold the repeat, so hunt for its SW sync. The
+// verdict on the first frame stands if nothing better comes along.
+static rts_decode_status_t next_frame(rts_decoder_t* decoder,
+                                      rts_decode_status_t status)
+{
+  if(decoder->first_status == RTS_DECODE_BUSY) {
+    decoder->first_status = (uint8_t)status;
+  }
+
+  // Keep where the failed frame started, there is no room for another frame
+  // after the last one
+  if(++decoder->failed_count == RTS_MAX_FAILED) {
+    decoder->state = STATE_DONE;
+    return (rts_decode_status_t)decoder->first_status;
+  }
+
+  decoder->state = STATE_HUNT;
+  decoder->skip = 0;
+  clear_frame(decoder);
+  decoder->frame.repeated = true;
+  return RTS_DECODE_BUSY;
+}
+
+static void clear_frame(rts_decoder_t* decoder)
+{
+  decoder->bit_count = 0;
+  decoder->prev_bit = 0;
+  decoder->raw_byte = 0;
+  decoder->prev_raw_byte = 0;
+  decoder->checksum = 0;
+  decoder->frame_valid = 0;
+
+  memset(decoder->frame.data, 0, sizeof(decoder->frame.data));
+  decoder->frame.bits = RTS_FRAME_BITS;
+  decoder->frame.known = false;
+  decoder->frame.combined = false;
+  decoder->frame.repaired = false;
+  decoder->frame.hw_sync = 0;
+
+  decoder->failed_start[decoder->failed_count] = SIZE_MAX;
+}
+
+// Protocol whose sync template best matches the runs ending with the current
+// one, a high run, if it matches well enough, and the samples it mismatched
+// in 1/32 samples. Of templates matching equally well, the first one.
+// RTS_PROTOCOL_COUNT if there is none.
+static unsigned int find_sync(const rts_decoder_t* decoder,
+                              uint32_t* mismatch)
+{
+  uint32_t hw_sync = decoder->sync_count != 0 ? rts_decoder_hw_sync(decoder)
+                                              : RTS_HW_SYNC_NOMINAL;
+  unsigned int best = RTS_PROTOCOL_COUNT;
+
+  *mismatch = UINT32_MAX;
+  for(unsigned int i = 0; i < RTS_PROTOCOL_COUNT; i++) {
+    const rts_protocol_t* protocol = protocols[i];
+    uint32_t length = 0;
+    for(size_t pulse = 0; pulse < protocol->sync_pulses; pulse++) {
+      length += protocol->sync[pulse].length;
+    }
+    uint32_t limit = length * hw_sync / HW_SYNC_WEIGHT / SYNC_MISMATCH_DIV;
+    uint32_t differ = correlate_sync(decoder, protocol, hw_sync, limit);
+    if(differ <= limit && differ < *mismatch) {
+      best = i;
+      *mismatch = differ;
+    }
+  }
+  return best;
+}
+
+// Lay the sync template of a protocol, scaled to a HW sync pulse of
+// 'hw_sync', over the runs so that it ends where the current run does, and
+// count the samples where their levels differ. All in 1/32 samples. Samples
+// before the capture all differ. Counting stops once past 'limit'.
+static uint32_t correlate_sync(const rts_decoder_t* decoder,
+                               const rts_protocol_t* protocol,
+                               uint32_t hw_sync,
+                               uint32_t limit)
+{
+  size_t i = decoder->run_count;
+  uint32_t left = 0;
+  unsigned int level = 0;
+  uint32_t mismatch = 0;
+
+  // The current run may not have been kept, and then the template cannot be
+  // laid over it
+  if(i >= RTS_MAX_RUNS) {
+    return UINT32_MAX;
+  }
+
+  // Walk back over the template pulses and the runs together, a stretch of
+  // the same level in both at a time
+  for(size_t pulse = protocol->sync_pulses; pulse > 0 && mismatch <= limit;
+      pulse--) {
+    const rts_sync_pulse_t* sync = &protocol->sync[pulse - 1];
+    uint32_t pulse_left = sync->length * hw_sync / HW_SYNC_WEIGHT;
+    while(pulse_left > 0 && mismatch <= limit) {
+      if(left == 0) {
+        if(i == 0) {
+          mismatch += pulse_left;
+          break;
+        }
+        i--;
+        left = RTS_RUN_LENGTH(decoder->runs[i]) * 32;
+        level = RTS_RUN_LEVEL(decoder->runs[i]);
+      }
+      uint32_t overlap = left < pulse_left ? left : pulse_left;
+      if(level != sync->level) {
+        mismatch += overlap;
+      }
+      left -= overlap;
+      pulse_left -= overlap;
+    }
+  }
+  return mismatch;
+}
+
+// The SW sync pulse of a frame ended 'length' samples after the start of the
+// current run, hand the runs after it to 'protocol'
+static void start_data(rts_decoder_t* decoder,
+                       unsigned int protocol,
+                       size_t length)
+{
+  decoder->state = STATE_DATA;
+  decoder->protocol = (uint8_t)protocol;
+  decoder->frame.protocol = (uint8_t)protocol;
+  decoder->frame_run = decoder->run_count;
+  decoder->frame.hw_sync = rts_decoder_hw_sync(decoder);
+  decoder->failed_start[decoder->failed_count] = decoder->run_start + length;
+}
+
+// Add a sync pulse to the measured timing of the remote, 'weight' is the
+// share of a HW sync pulse its length counts for, in 1/32
+static void add_sync(rts_decoder_t* decoder, size_t length, uint32_t weight)
+{
+  decoder->sync_sum += (uint32_t)length * weight;
+  decoder->sync_count++;
+  update_timing(decoder);
+}
+
+// Scale the pulse length limits to the measured length H of a HW sync pulse,
+// 4 half-bits long. At the nominal 15.5 samples these are the fixed limits.
+//   long run:   at least 1.5 half-bits, ceil(3H / 8)
+//   invalid:    3 half-bits or more, ceil(3H / 4)
+//   SW sync:    the nominal window of each protocol times H / 15.5, rounded
+//               outwards
+// The SW sync windows only ever widen, so that a glitch in a HW sync pulse
+// cannot lose a frame sent at the nominal rate.
+static void update_timing(rts_decoder_t* decoder)
+{
+  uint32_t sum = decoder->sync_sum;
+  uint32_t d = (uint32_t)decoder->sync_count * HW_SYNC_WEIGHT;
+  uint32_t nominal = (uint32_t)decoder->sync_count * RTS_HW_SYNC_NOMINAL;
+
+  decoder->long_run_min = (uint8_t)((3 * sum + 8 * d - 1) / (8 * d));
+  decoder->long_run_max = (uint8_t)((3 * sum + 4 * d - 1) / (4 * d) - 1);
+
+  for(size_t i = 0; i < RTS_PROTOCOL_COUNT; i++) {
+    const rts_protocol_t* protocol = protocols[i];
+    uint32_t sw_min = (protocol->sw_sync_min * sum) / nominal;
+    uint32_t sw_max = (protocol->sw_sync_max * sum + nominal - 1) / nominal;
+    decoder->sw_sync_min[i] = (uint8_t)(sw_min < protocol->sw_sync_min
+                                        ? sw_min : protocol->sw_sync_min);
+    decoder->sw_sync_max[i] = (uint8_t)(sw_max > protocol->sw_sync_max
+                                        ? sw_max : protocol->sw_sync_max);
+  }
+}
+
+
+// Map a run length onto RUN_SHORT, RUN_LONG or RUN_INVALID without branching
+static inline unsigned int quantise_run(const rts_decoder_t* decoder,
+                                        size_t length)
+{
+  return (unsigned int)(length >= decoder->long_run_min)
+         + (length > decoder->long_run_max);
+}
+
+// Take the next run of a Somfy RTS frame
+static rts_decode_status_t somfy_run(rts_decoder_t* decoder, uint8_t run)
+{
+  return manchester_run(decoder, run, FORMAT_RTS);
+}
+
+// Take the next run of what looks like the rest of an extended frame. A run
+// which cannot be part of it means the frame ended after 56 bits after all,
+// or broke. Either way it is repaired as an ordinary frame if it can be.
+static rts_decode_status_t extended_run(rts_decoder_t* decoder, uint8_t run)
+{
+  rts_decode_status_t status = manchester_run(decoder, run, FORMAT_EXT);
+  return status == RTS_DECODE_BAD_PULSE ? repair_frame(decoder) : status;
+}
+
+// Manchester decoding is based on edge length + previous bit value, and each
+// run starts in the middle of a Manchester bit
+__STATIC_FORCEINLINE rts_decode_status_t manchester_run(rts_decoder_t* decoder,
+                                                        uint8_t run,
+                                                        frame_format_t format)
+{
+  // The low time after the SW sync looks like the second half of a 0, so
+  // the first bit is decoded as if it followed one.
+  uint8_t entry = manchester_table[decoder->prev_bit]
+                                  [quantise_run(decoder, RTS_RUN_LENGTH(run))];
+  if(entry & BAD_RUN) {
+    return RTS_DECODE_BAD_PULSE;
+  }
+  decoder->skip = (entry & SKIP_RUN) ? 1 : 0;
+  return emit_bit(decoder, entry & EMIT_1, format);
+}
+
+// Shift a decoded bit into the frame. De-'obfuscation' and the 'checksum' are
+// updated per completed byte, so the verdict is known with the last bit.
+__STATIC_FORCEINLINE rts_decode_status_t emit_bit(rts_decoder_t* decoder,
+                                                  unsigned int bit,
+                                                  frame_format_t format)
+{
+  decoder->prev_bit = (uint8_t)bit;
+  decoder->raw_byte = (uint8_t)((decoder->raw_byte << 1) | bit);
+  decoder->bit_count++;
+
+  if((decoder->bit_count % 8) == 0) {
+    PROFILE_STAGE(RTS_STAGE_CHECKSUM);
+    uint8_t byte = decoder->raw_byte ^ decoder->prev_raw_byte;
+    decoder->frame.data[decoder->bit_count / 8 - 1] = byte;
+    if(decoder->bit_count / 8 <= format.checksum_bytes) {
+      decoder->checksum ^= byte ^ (byte >> 4);
+    }
+    decoder->prev_raw_byte = decoder->raw_byte;
+    PROFILE_STAGE(RTS_STAGE_MANCHESTER);
+  }
+
+  if(format.lookup_bits != 0
+     && decoder->bit_count == format.lookup_bits
+     && decoder->lookup != NULL
+     && decoder->lookup(&decoder->frame)) {
+    // Seen before, and the rest of it already checked out back then
+    decoder->frame.known = true;
+    decoder->state = STATE_DONE;
+    return RTS_DECODE_OK;
+  }
+
+  if(decoder->bit_count < format.bits) {
+    return RTS_DECODE_BUSY;
+  }
+
+  PROFILE_STAGE(RTS_STAGE_CHECKSUM);
+
+  if((decoder->checksum & 0xF) == 0) {
+    decoder->frame.bits = format.bits;
+    if(format.bits == RTS_EXT_FRAME_BITS) {
+      decoder->state = STATE_DONE;
+      return RTS_DECODE_OK;
+    }
+    // One extended frame in 16 passes the checksum after 56 bits as well, so
+    // the frame is only done once the gap after it is seen
+    decoder->frame_valid = 1;
+  }
+
+  // Reading a long run as short makes the frame one run longer, and an
+  // extended frame goes on after 56 bits, so wait for the next run. It must
+  // not be eaten as the second half of the last bit yet.
+  decoder->state = STATE_REPAIR;
+  decoder->frame_skip = decoder->skip;
+  decoder->skip = 0;
+  return RTS_DECODE_BUSY;
+}
+
+// A frame failed its checksum, or passed it after 56 bits, and the run after
+// its last bit is in. After 56 bits, a run which can be part of a frame means
+// it may be an extended one.
+static rts_decode_status_t end_frame(rts_decoder_t* decoder, uint8_t run)
+{
+  if(decoder->bit_count == RTS_FRAME_BITS
+     && quantise_run(decoder, RTS_RUN_LENGTH(run)) != RUN_INVALID) {
+    decoder->frame_end = decoder->run_count;
+    decoder->state = STATE_EXTENDED;
+    decoder->skip = 0;
+    return decoder->frame_skip ? RTS_DECODE_BUSY
+                               : extended_run(decoder, run);
+  }
+
+  return repair_frame(decoder);
+}
+
+// Repair a frame which failed its checksum, as an extended frame if it got
+// that far, and as an ordinary frame otherwise. A frame which passed it after
+// 56 bits is taken as it is if it ended there. The second half of a last 1
+// bit was then taken for the first bit of an extended frame, and the gap
+// broke the second.
+static rts_decode_status_t repair_frame(rts_decoder_t* decoder)
+{
+  if(decoder->frame_valid && decoder->bit_count <= RTS_FRAME_BITS + 1) {
+    decoder->state = STATE_DONE;
+    return RTS_DECODE_OK;
+  }
+
+  if(decoder->state == STATE_REPAIR
+     && decoder->bit_count == RTS_FRAME_BITS) {
+    decoder->frame_end = decoder->run_count;
+  } else if(decoder->bit_count == RTS_EXT_FRAME_BITS
+            && repair(decoder, FORMAT_EXT, decoder->run_count)) {
+    return RTS_DECODE_OK;
+  }
+
+  // An extended frame whose first 56 bits passed on their own is not cut
+  // short to them. Any repair of those would fail the checksum anyway.
+  if(decoder->frame_valid) {
+    decoder->state = STATE_DONE;
+    return RTS_DECODE_CHECKSUM;
+  }
+
+  return repair(decoder, FORMAT_RTS, decoder->frame_end)
+         ? RTS_DECODE_OK : RTS_DECODE_CHECKSUM;
+}
+
+// Read each of the least certain runs of the frame, up to run 'end', as the
+// other length class in turn, and keep the first frame which passes
+static bool repair(rts_decoder_t* decoder, frame_format_t format, size_t end)
+{
+  weak_runs_t weak = { .count = 0 };
+
+  PROFILE_STAGE(RTS_STAGE_MANCHESTER);
+  decoder->state = STATE_DONE;
+
+  // Runs past RTS_MAX_RUNS were not kept
+  if(end >= RTS_MAX_RUNS) {
+    return false;
+  }
+
+  redecode(decoder, format, end, SIZE_MAX, &weak);
+  for(size_t i = 0; i < weak.count; i++) {
+    if(redecode(decoder, format, end, weak.run[i], NULL)) {
+      decoder->frame.repaired = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Manchester decode the runs of the frame again, up to run 'end', with run
+// 'flip' read as the other length class. Returns true and fills in the frame
+// if that makes a frame which passes the checksum and has the right key
+// nibble. If 'weak' is given, the least certain runs which decided a bit are
+// gathered in it.
+static bool redecode(rts_decoder_t* decoder,
+                     frame_format_t format,
+                     size_t end,
+                     size_t flip,
+                     weak_runs_t* weak)
+{
+  uint8_t raw[RTS_EXT_FRAME_BYTES] = { 0 };
+  unsigned int bit = 0;
+  size_t bits = 0;
+  bool skip = false;
+
+  for(size_t i = decoder->frame_run; i < end && bits < format.bits; i++) {
+    if(skip) {
+      skip = false;
+      continue;
+    }
+
+    size_t length = RTS_RUN_LENGTH(decoder->runs[i]);
+    unsigned int run_class = quantise_run(decoder, length);
+    if(i == flip && run_class != RUN_INVALID) {
+      run_class ^= RUN_LONG;
+    }
+
+    uint8_t entry = manchester_table[bit][run_class];
+    if(entry & BAD_RUN) {
+      return false;
+    }
+    skip = (entry & SKIP_RUN) != 0;
+    bit = entry & EMIT_1;
+    raw[bits / 8] |= (uint8_t)(bit << (7 - (bits % 8)));
+    bits++;
+
+    if(weak != NULL) {
+      size_t limit = decoder->long_run_min;
+      add_weak(weak, i, length >= limit ? length - limit : limit - length);
+    }
+  }
+
+  if(bits < format.bits) {
+    return false;
+  }
+
+  uint8_t data[RTS_EXT_FRAME_BYTES] = { 0 };
+  uint8_t prev = 0;
+  uint8_t checksum = 0;
+  for(size_t i = 0; i < format.bits / 8; i++) {
+    data[i] = raw[i] ^ prev;
+    if(i < format.checksum_bytes) {
+      checksum ^= data[i] ^ (data[i] >> 4);
+    }
+    prev = raw[i];
+  }
+  if((checksum & 0xF) != 0 || (data[0] >> 4) != RTS_KEY_NIBBLE) {
+    return false;
+  }
+
+  memcpy(decoder->frame.data, data, sizeof(data));
+  decoder->frame.bits = format.bits;
+  return true;
+}
+
+// Keep a run if it is among the least certain so far. Of runs equally
+// certain, the earliest is kept.
+static void add_weak(weak_runs_t* weak, size_t run, unsigned int confidence)
+{
+  if(confidence > REPAIR_MAX_CONFIDENCE) {
+    return;
+  }
+
+  size_t i = weak->count < REPAIR_RUNS ? weak->count++ : REPAIR_RUNS;
+  while(i > 0 && weak->confidence[i - 1] > confidence) {
+    if(i < REPAIR_RUNS) {
+      weak->run[i] = weak->run[i - 1];
+      weak->confidence[i] = weak->confidence[i - 1];
+    }
+    i--;
+  }
+  if(i < REPAIR_RUNS) {
+    weak->run[i] = run;
+    weak->confidence[i] = confidence;
+  }
+}
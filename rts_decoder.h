@@ -0,0 +1,358 @@
+/***************************************************************************//**
+ * @file rts_decoder.h
+ * @brief Somfy RTS frame decoder
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef RTS_DECODER_H
+#define RTS_DECODER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of data bits in an RTS frame
+#define RTS_FRAME_BITS  56
+/// Number of bytes in a decoded RTS frame
+#define RTS_FRAME_BYTES (RTS_FRAME_BITS / 8)
+/// Newer remotes and sensors send extended frames, 24 bits longer. Their first
+/// RTS_FRAME_BITS are laid out as in an RTS frame.
+#define RTS_EXT_FRAME_BITS  80
+#define RTS_EXT_FRAME_BYTES (RTS_EXT_FRAME_BITS / 8)
+
+/// A capture is decoded from its pulse-width (run-length) representation. Each
+/// run is one byte: the line level in the top bit and the run length, in
+/// oversampled bits and saturated at RTS_RUN_LENGTH_MAX, in the remaining bits.
+#define RTS_RUN_LEVEL(run)  ((run) >> 7)
+#define RTS_RUN_LENGTH(run) ((run) & RTS_RUN_LENGTH_MAX)
+#define RTS_RUN_LENGTH_MAX  0x7F
+/// Even a badly corrupted capture rarely needs more than this many runs. Once
+/// they are used up, the decoder stops looking for a frame.
+#define RTS_MAX_RUNS        256
+
+/// Frame bits decoded before the decoder asks whether it has seen the frame
+/// before, see rts_frame_lookup_t. They hold the key, button, checksum and
+/// rolling code, everything that changes from one press to the next.
+#define RTS_LOOKUP_BITS     32
+
+/// Every RTS remote sends this in the top nibble of the first frame byte. The
+/// checksum alone lets one frame in 16 through, so a frame which only decoded
+/// after a second guess, a repair or a vote, has to match it too.
+#define RTS_KEY_NIBBLE      0xA
+
+/// Length of a HW sync pulse sent at the nominal rate, in 1/32 samples. Pulse
+/// timing is passed around in this unit, see rts_frame_t.hw_sync.
+#define RTS_HW_SYNC_NOMINAL 496
+
+/// A capture is long enough for the first frame and one repeat, so at most
+/// this many frames in it can fail
+#define RTS_MAX_FAILED      2
+
+/// Outcome of feeding a capture to the decoder
+typedef enum {
+  RTS_DECODE_BUSY = 0,    ///< No verdict yet, more of the capture is needed
+  RTS_DECODE_OK,          ///< A frame with a valid checksum was decoded
+  RTS_DECODE_NO_SYNC,     ///< No sync pulses where a frame should start
+  RTS_DECODE_TRUNCATED,   ///< Capture ended before all frame bits were seen
+  RTS_DECODE_BAD_PULSE,   ///< Manchester pulse too long to be part of a frame
+  RTS_DECODE_CHECKSUM,    ///< All frame bits decoded, but checksum mismatch
+} rts_decode_status_t;
+
+/// Protocols the decoder tells apart by their sync pulse, see rts_protocol_t
+typedef enum {
+  RTS_PROTOCOL_SOMFY = 0, ///< Somfy RTS
+  RTS_PROTOCOL_COUNT
+} rts_protocol_id_t;
+
+#if defined(RTS_DECODER_PROFILE)
+/// Decoder stages, used to attribute decode time when profiling
+typedef enum {
+  RTS_STAGE_RUN_EXTRACTION = 0,
+  RTS_STAGE_GLITCH_FILTER,
+  RTS_STAGE_SYNC_SEARCH,
+  RTS_STAGE_MANCHESTER,
+  RTS_STAGE_CHECKSUM,
+  RTS_STAGE_COUNT
+} rts_decoder_stage_t;
+#endif
+
+/// A capture as it sits in the RX FIFO. Where the packet wraps around the end
+/// of the FIFO, it continues at the start in a second portion.
+typedef struct {
+  const uint8_t* first;   ///< First portion of the capture
+  size_t first_length;    ///< Bytes in the first portion
+  const uint8_t* last;    ///< Rest of the capture, if any
+  size_t length;          ///< Bytes in the whole capture
+} rts_capture_t;
+
+/// A decoded (de-obfuscated) RTS frame
+typedef struct {
+  uint8_t data[RTS_EXT_FRAME_BYTES];
+  uint8_t bits;           ///< RTS_FRAME_BITS, or RTS_EXT_FRAME_BITS if extended
+  bool repeated;          ///< Frame was preceded by the longer repeat sync
+  bool known;             ///< Completed by the lookup, see rts_frame_lookup_t
+  bool combined;          ///< Voted together from frames which failed alone
+  bool repaired;          ///< Checksum only passed after re-reading a run
+  uint16_t hw_sync;       ///< Measured HW sync pulse length, 0 if unknown
+  uint8_t protocol;       ///< Protocol of the frame, a rts_protocol_id_t
+} rts_frame_t;
+
+/// Called once the first RTS_LOOKUP_BITS of a frame are decoded, with those
+/// bytes in 'frame'. Returns true to stop decoding there, after filling in the
+/// rest of the frame from the earlier frame it matches.
+typedef bool (*rts_frame_lookup_t)(rts_frame_t* frame);
+
+/// Decoder state. Runs are kept after decoding so they can be inspected.
+typedef struct {
+  rts_frame_lookup_t lookup;  ///< Frame lookup, optional. Kept across starts.
+
+  uint8_t runs[RTS_MAX_RUNS];
+  size_t run_count;       ///< Runs handed to the state machine so far
+  size_t runs_kept;       ///< Runs in 'runs', run_count may lag behind
+
+  size_t bytes;           ///< Capture bytes fed so far
+  size_t word_start;      ///< First sample of the word waiting to be decoded
+  size_t run_start;       ///< First sample of the current run
+  uint32_t prev;          ///< Word before the one waiting to be decoded
+  uint32_t cur;           ///< Word waiting for its successor to be decoded
+  uint32_t partial;       ///< Bytes of the next word received so far
+  uint8_t level;          ///< Level of the current run
+  uint8_t status;         ///< Verdict so far, a rts_decode_status_t
+  uint8_t first_status;   ///< Why the first frame failed, if it did
+
+  uint8_t state;
+  uint8_t skip;
+  uint8_t bit_count;
+  uint8_t prev_bit;
+  uint8_t raw_byte;
+  uint8_t prev_raw_byte;
+  uint8_t checksum;
+  size_t frame_run;       ///< First run after the SW sync of the frame
+  size_t frame_end;       ///< Run after the first RTS_FRAME_BITS of the frame
+  uint8_t frame_skip;     ///< That run was the second half of the last bit
+  uint8_t frame_valid;    ///< The first RTS_FRAME_BITS passed the checksum
+  uint8_t protocol;       ///< Protocol of the frame, a rts_protocol_id_t
+
+  /// Best match of a sync template so far, while later falling edges may
+  /// still match better. sync_protocol is RTS_PROTOCOL_COUNT if there is none.
+  uint8_t sync_protocol;
+  uint8_t sync_length;    ///< Length of its SW sync pulse
+  size_t sync_run;        ///< Run of its SW sync pulse
+  size_t sync_start;      ///< First sample of its SW sync pulse
+  size_t sync_until;      ///< Taken once the runs are past this sample
+  uint32_t sync_mismatch; ///< Samples it mismatched, in 1/32 samples
+
+  /// Sync pulses measured so far, see rts_decode_capture(), and the pulse
+  /// length limits derived from them. The SW sync window is kept for each
+  /// protocol.
+  uint32_t sync_sum;
+  uint8_t sync_count;
+  uint8_t sw_sync_min[RTS_PROTOCOL_COUNT];
+  uint8_t sw_sync_max[RTS_PROTOCOL_COUNT];
+  uint8_t long_run_min;
+  uint8_t long_run_max;
+
+  rts_frame_t frame;
+
+  /// First sample after the SW sync of each frame which failed to decode,
+  /// SIZE_MAX if its SW sync was never found
+  size_t failed_start[RTS_MAX_FAILED];
+  uint8_t failed_count;
+} rts_decoder_t;
+
+/// A pulse of a sync template
+typedef struct {
+  uint8_t level;          ///< 1 for high
+  uint8_t length;         ///< Nominal length, in 1/32 of a HW sync pulse
+} rts_sync_pulse_t;
+
+/// A protocol the decoder can hand frames to. Run extraction and the glitch
+/// filter are shared by all of them. The sync pulses ahead of a frame are
+/// matched once against the sync template of each protocol, and only the
+/// protocol matching best sees the runs of the frame.
+typedef struct {
+  /// Sync template, the pulses ahead of a frame in the order they are sent.
+  /// The last one is the SW sync pulse, which is high. Its length scales with
+  /// the timing measured on the HW sync pulses.
+  const rts_sync_pulse_t* sync;
+  uint8_t sync_pulses;    ///< Pulses in 'sync'
+  uint8_t sw_sync_min;    ///< Shortest SW sync pulse at the nominal rate
+  uint8_t sw_sync_max;    ///< Longest SW sync pulse at the nominal rate
+  /// Share of a HW sync pulse the SW sync pulse counts for when measuring the
+  /// timing of the remote, in 1/32. 0 leaves it out of the measurement.
+  uint8_t sw_sync_weight;
+  /// Takes each run of a frame, from the first one after its SW sync pulse.
+  /// Returns RTS_DECODE_BUSY until there is a verdict on the frame.
+  rts_decode_status_t (*on_run)(rts_decoder_t* decoder, uint8_t run);
+} rts_protocol_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Get a byte of a capture, regardless of which portion it is in.
+ *
+ * @param capture Capture
+ * @param index Byte index, must be less than capture->length
+ * @returns Captured byte, earliest sample in the MSB
+ *****************************************************************************/
+static inline uint8_t rts_capture_byte(const rts_capture_t* capture,
+                                       size_t index)
+{
+  return index < capture->first_length
+         ? capture->first[index]
+         : capture->last[index - capture->first_length];
+}
+
+/**************************************************************************//**
+ * Decode an oversampled RTS capture in a single pass.
+ *
+ * @param decoder Decoder state, receives the frame and the capture runs
+ * @param capture Captured samples, MSB first. Read in place and never beyond
+ *                its length, so it can point straight into the RX FIFO.
+ * @returns Decode verdict, the frame is valid for RTS_DECODE_OK
+ *
+ * Samples are glitch filtered a word at a time and turned into runs, and each
+ * run is handed to the sync/Manchester state machine as soon as it ends.
+ * De-obfuscation and the checksum are kept up to date per decoded byte, so
+ * decoding stops as soon as the last frame bit is known, or as soon as
+ * decoder->lookup recognises the frame.
+ *
+ * The SW sync ahead of a frame is found by laying the sync template of each
+ * protocol over the runs ending at each falling edge. Once one matches
+ * closely enough, the edges which follow within as many samples as it
+ * mismatched are tried as well, and the best match of them all is taken. A
+ * glitch which splits a sync pulse costs only the samples it covers, where
+ * counting edges would be thrown off altogether.
+ *
+ * If a frame fails to decode, the decoder hunts for the SW sync of the next
+ * one and decodes that instead, up to RTS_MAX_FAILED frames. Only if no
+ * frame in the capture decodes is the failure of the first one reported.
+ * Where each failed frame starts is left in decoder->failed_start, so that it
+ * can be combined with failed copies from other captures of the same press.
+ * A jammed capture, which fills up RTS_MAX_RUNS runs without a frame in
+ * them, is given up on there, so the time a capture takes to decode is
+ * bounded whatever is in it.
+ *
+ * Remotes are not all equally fast, and drift with temperature and battery
+ * level. The HW and SW sync pulses ahead of a frame are measured, and the SW
+ * sync window and the Manchester run limits are scaled to them, so a remote
+ * running well off the nominal rate still decodes on the first frame.
+ *
+ * A run of 5 to 7 samples is about as close to a short (4) as to a long (8)
+ * run, and the Manchester phase of every bit after it hangs on reading it
+ * right. If a frame fails its checksum, its least certain runs are read as
+ * the other length in turn, and the first frame which then passes is taken,
+ * marked as repaired.
+ *
+ * A frame which goes on with Manchester runs after RTS_FRAME_BITS is decoded
+ * on as an extended frame, whether or not the first RTS_FRAME_BITS passed the
+ * checksum, and only the checksum over all RTS_EXT_FRAME_BITS decides. An
+ * extended frame which fails that is repaired as an ordinary frame, unless its
+ * first RTS_FRAME_BITS passed on their own. frame.bits says which kind it was.
+ *
+ * Other OOK remotes on 433.42 MHz send frames of their own after a sync pulse
+ * of another length. Each protocol the decoder knows is a rts_protocol_t, and
+ * the one whose sync template matches best decodes the frame. frame.protocol
+ * says which one it was.
+ *****************************************************************************/
+rts_decode_status_t rts_decode_capture(rts_decoder_t* decoder,
+                                       const rts_capture_t* capture);
+
+/**************************************************************************//**
+ * Start decoding a capture a chunk at a time.
+ *
+ * @param decoder Decoder state
+ *
+ * Feed the capture with rts_decoder_feed() as it comes in, and call
+ * rts_decoder_finish() once it is complete. The result is the same as
+ * decoding the whole capture with rts_decode_capture(), but the verdict can
+ * be known well before the end of the capture.
+ *****************************************************************************/
+void rts_decoder_start(rts_decoder_t* decoder);
+
+/**************************************************************************//**
+ * Start decoding samples which begin right after the SW sync of a frame,
+ * rather than a whole capture. Feed and finish as for rts_decoder_start().
+ *
+ * @param decoder Decoder state
+ *****************************************************************************/
+void rts_decoder_start_frame(rts_decoder_t* decoder);
+
+/**************************************************************************//**
+ * Set the decoder up for the pulse timing of a known remote, rather than for
+ * the nominal rate.
+ *
+ * @param decoder Decoder state, just started
+ * @param hw_sync HW sync pulse length of the remote in 1/32 samples, as
+ *                learned from rts_frame_t.hw_sync
+ * @returns false if that is too far off to be a HW sync pulse, the decoder is
+ *          left as it was then
+ *
+ * The length counts as one measured sync pulse, so the sync pulses of the
+ * capture still refine it.
+ *****************************************************************************/
+bool rts_decoder_set_timing(rts_decoder_t* decoder, uint16_t hw_sync);
+
+/**************************************************************************//**
+ * Get the HW sync pulse length measured on the capture so far.
+ *
+ * @param decoder Decoder state
+ * @returns Mean length of the sync pulses measured, scaled to a HW sync pulse,
+ *          in 1/32 samples. 0 if none were measured.
+ *
+ * Also valid after a capture failed to decode, as long as the decoder has not
+ * been started again. A timing set with rts_decoder_set_timing() counts as
+ * one measured pulse.
+ *****************************************************************************/
+uint16_t rts_decoder_hw_sync(const rts_decoder_t* decoder);
+
+/**************************************************************************//**
+ * Decode the part of a capture that has not been fed yet.
+ *
+ * @param decoder Decoder state, started with rts_decoder_start()
+ * @param capture Capture received so far. Bytes already fed must not change,
+ *                but the capture can have grown since the last call.
+ * @returns Decode verdict, RTS_DECODE_BUSY until one is known. The frame is
+ *          valid for RTS_DECODE_OK.
+ *****************************************************************************/
+rts_decode_status_t rts_decoder_feed(rts_decoder_t* decoder,
+                                     const rts_capture_t* capture);
+
+/**************************************************************************//**
+ * Finish decoding a capture, after all of it has been fed.
+ *
+ * @param decoder Decoder state
+ * @returns Decode verdict, the frame is valid for RTS_DECODE_OK
+ *****************************************************************************/
+rts_decode_status_t rts_decoder_finish(rts_decoder_t* decoder);
+
+#if defined(RTS_DECODER_PROFILE)
+/**************************************************************************//**
+ * Called by the decoder whenever it moves on to another stage.
+ *
+ * @param stage Stage the decoder is entering
+ *
+ * Only called when the decoder is built with RTS_DECODER_PROFILE, and
+ * provided by whatever does the profiling (see bench/).
+ *****************************************************************************/
+void rts_decoder_profile_stage(rts_decoder_stage_t stage);
+#endif
+
+#endif  // RTS_DECODER_H
@@ -0,0 +1,126 @@
+/***************************************************************************//**
+ * @file rx_packet_queue.c
+ * @brief Hand-off of received packets from the RAIL ISR to the main loop
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "rx_packet_queue.h"
+#include "em_device.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (RX_PACKET_QUEUE_SIZE & (RX_PACKET_QUEUE_SIZE - 1)) != 0
+#error "RX_PACKET_QUEUE_SIZE must be a power of two"
+#endif
+
+// Indices run freely and wrap at 256, so head - tail is always the depth
+#define SLOT(index) ((index) & (RX_PACKET_QUEUE_SIZE - 1))
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static rx_packet_t queue[RX_PACKET_QUEUE_SIZE];
+// Written by the ISR only
+static volatile uint8_t head = 0;
+static volatile uint32_t queued = 0;
+static volatile uint32_t dropped = 0;
+static volatile uint8_t max_depth = 0;
+// Written by the main loop only
+static volatile uint8_t tail = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/******************************************************************************
+ * Queue a packet (ISR)
+ *****************************************************************************/
+bool rx_packet_queue_push(const rx_packet_t* packet)
+{
+  if(rx_packet_queue_try_push(packet)) {
+    return true;
+  }
+
+  dropped++;
+  return false;
+}
+
+/******************************************************************************
+ * Queue a packet without counting a drop (ISR)
+ *****************************************************************************/
+bool rx_packet_queue_try_push(const rx_packet_t* packet)
+{
+  uint8_t h = head;
+  uint8_t depth = (uint8_t)(h - tail);
+
+  if(depth >= RX_PACKET_QUEUE_SIZE) {
+    return false;
+  }
+
+  queue[SLOT(h)] = *packet;
+  // The entry must be complete before the main loop can see it
+  __DMB();
+  head = (uint8_t)(h + 1);
+
+  queued++;
+  if(depth + 1 > max_depth) {
+    max_depth = depth + 1;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Take the oldest packet off the queue (main loop)
+ *****************************************************************************/
+bool rx_packet_queue_pop(rx_packet_t* packet)
+{
+  uint8_t t = tail;
+
+  if(t == head) {
+    return false;
+  }
+
+  // Read the entry only after seeing it published
+  __DMB();
+  *packet = queue[SLOT(t)];
+  __DMB();
+  tail = (uint8_t)(t + 1);
+  return true;
+}
+
+/******************************************************************************
+ * Get the queue telemetry
+ *****************************************************************************/
+void rx_packet_queue_get_stats(rx_packet_queue_stats_t* stats)
+{
+  stats->queued = queued;
+  stats->dropped = dropped;
+  stats->depth = (uint8_t)(head - tail);
+  stats->max_depth = max_depth;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+/***************************************************************************//**
+ * @file rx_packet_queue.h
+ * @brief Hand-off of received packets from the RAIL ISR to the main loop
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef RX_PACKET_QUEUE_H
+#define RX_PACKET_QUEUE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "rail.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rts_decoder.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of queue entries, must be a power of two. The RX FIFO cannot hold
+/// more complete captures than this anyway.
+#define RX_PACKET_QUEUE_SIZE 8
+
+/// A received packet, held in the RX FIFO until the main loop releases it.
+/// A capture already decoded while it was being received is not held, and
+/// carries its frame instead.
+typedef struct {
+  RAIL_RxPacketHandle_t handle;   ///< Held packet
+  RAIL_Time_t timestamp;          ///< RAIL time when the ISR saw the packet
+  RAIL_Events_t events;           ///< Events reported together with it
+  int8_t rssi;                    ///< Packet RSSI in dBm
+  rts_decode_status_t status;     ///< RTS_DECODE_OK, or RTS_DECODE_BUSY if held
+  rts_frame_t frame;              ///< Decoded frame, for RTS_DECODE_OK
+} rx_packet_t;
+
+/// Queue telemetry
+typedef struct {
+  uint32_t queued;                ///< Packets handed to the main loop
+  uint32_t dropped;               ///< Packets not held because queue was full
+  uint8_t depth;                  ///< Current number of queued packets
+  uint8_t max_depth;              ///< Highest depth seen
+} rx_packet_queue_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Queue a packet. Producer side, only call from the RAIL event ISR.
+ *
+ * @param packet Packet to queue
+ * @returns true if queued, false if the queue was full
+ *
+ * Wait-free: the ISR only writes the head index and the main loop only writes
+ * the tail index, so neither side ever has to lock out the other.
+ *****************************************************************************/
+bool rx_packet_queue_push(const rx_packet_t* packet);
+
+/**************************************************************************//**
+ * Queue a packet, without counting it as dropped if the queue is full.
+ * Producer side, only call from the RAIL event ISR.
+ *
+ * @param packet Packet to queue
+ * @returns true if queued, false if the queue was full
+ *
+ * For a packet which can still be queued some other way if this fails.
+ *****************************************************************************/
+bool rx_packet_queue_try_push(const rx_packet_t* packet);
+
+/**************************************************************************//**
+ * Take the oldest packet off the queue. Consumer side, main loop only.
+ *
+ * @param packet Receives the packet
+ * @returns true if a packet was dequeued, false if the queue was empty
+ *****************************************************************************/
+bool rx_packet_queue_pop(rx_packet_t* packet);
+
+/**************************************************************************//**
+ * Get the queue telemetry.
+ *
+ * @param stats Receives the telemetry
+ *****************************************************************************/
+void rx_packet_queue_get_stats(rx_packet_queue_stats_t* stats);
+
+#endif  // RX_PACKET_QUEUE_H